@@ -15,40 +15,46 @@
 #include "driverlib/gpio.h"
 #include "driverlib/sysctl.h"
 #include "driverlib/systick.h"
+#include "driverlib/timer.h"
 #include "driverlib/interrupt.h"
 #include "driverlib/debug.h"
 #include "utils/ustdlib.h"
-#include "circBufT.h"
 #include "buttons4.h"
 #include "OrbitOLED/OrbitOLEDInterface.h"
 #include "motorControl.h"
 #include "PIDController.h"
 #include "heliYaw.h"
 #include "serialCom.h"
+#include "heliHeight.h"
+#include "telemetry.h"
+#include "displayCache.h"
+#include "cpuCycles.h"
+#include "timingConfig.h"
+#include "scheduler.h"
+#include "profile.h"
 #include "driverlib/pwm.h"
 
 //*****************************************************************************
 // Constants
 //*****************************************************************************
-#define BUF_SIZE 50 //Size of buffer to be used to average height sensor
-#define SAMPLE_RATE_HZ 200
 #define ANGLE_CONVERSION 360/448 //Degrees per encoder pulse
+#define HOMING_YAW_RATE -90      //Yaw rate of the spin to find the reference, degrees per second
+#define HOMING_MAIN_DUTY 30      //Main rotor duty while spinning to find the reference
 
 //************************************************************************
 // Global variables
 //*****************************************************************************
-//Circular buffer for altitude ADC
-static circBuf_t    g_inBuffer;		    // Buffer of size BUF_SIZE integers (sample values)
-
 //Heli rig height parameters
 static uint16_t     currentHeight;
 static uint16_t     currentHeightADC;      // Mean ADC height value calculated
+static int32_t      currentHeightRate;     // Rate of currentHeightADC, counts per second
 static uint16_t     targetHeight;
 static uint16_t     targetHeightADC;
 static uint16_t     landedHeight;          // The ADC value for helicopter landed state
 
 //Heli rig yaw parameters
 static int16_t      currentYaw;
+static int16_t      currentYawRate;        // Degrees per second
 static int16_t      targetYaw = 0;
 
 //Flight mode for landing or flying sortie programs
@@ -57,54 +63,27 @@ static uint8_t      flightMode = 0; //Set flight mode state to landed at start
 //Flag for completed heli landing, triggered if landing proceedure and at landed height and reference yaw
 static uint8_t      landed = true;
 
-//4Hz clock tick
-static uint8_t      slowTick = false;
+//Set by the flight mode logic when the controllers should drive the rotors, or the tail should spin to find home
+static volatile uint8_t controlActive = false;
+static volatile uint8_t homingActive = false;
+
+//Duty cycles last applied by the controllers, parts per PWM_DUTY_SCALE, for display and serial output
+static uint16_t     dutyMain;
+static uint16_t     dutyTail;
 
 //*****************************************************************************
 // The interrupt handler for the for SysTick interrupt.
 //*****************************************************************************
 void
 SysTickIntHandler(void)
-/* ISR triggered on each clock pulse. Used to trigger ADC conversion of analogue output of altitude sensor, and updating slow tick
- * signal at 4Hz for control of serial output and PID controller
+/* ISR triggered on each clock pulse. Advances the uptime clock, and in the HEIGHT_ADC_PROCESSOR_TRIGGER build triggers
+ * ADC conversion of analogue output of altitude sensor
  */
 {
-    static uint8_t tickCount = 0;
-
-    const uint8_t ticksPerSlow = SYSTICK_RATE_HZ / SLOWTICK_RATE_HZ;
-
-    //
-    // Initiate a conversion
-    //
-    ADCProcessorTrigger(ADC0_BASE, 3); 
-
-    if (++tickCount >= ticksPerSlow)
-    {                       // Signal a slow tick
-        tickCount = 0;
-        slowTick = true; //Ticks every 4Hz
-    }
-}
-
-//*****************************************************************************
-// The handler for the ADC conversion complete interrupt, and peripheral button and switch events.
-// Writes to the circular buffer.
-//*****************************************************************************
-void
-ADCIntHandler(void)
-/* ISR for ADC conversion of altitude sensor output voltage, and storage of value into circular buffer at an updated
- * pointer. Uses circBuffer module
- */
-{
-	uint32_t ulValue;
-	// Get the single sample from ADC0.  ADC_BASE is defined in
-	// inc/hw_memmap.h
-	ADCSequenceDataGet(ADC0_BASE, 3, &ulValue);
-	//
-	// Place it in the circular buffer (advancing write index)
-	writeCircBuf (&g_inBuffer, ulValue);
-	//
-	// Clean up, clearing the interrupt
-	ADCIntClear(ADC0_BASE, 3);
+    PROFILE_START(PROFILE_SYSTICK_ISR);
+    tickUptime();
+    triggerHeightSample();
+    PROFILE_END(PROFILE_SYSTICK_ISR);
 }
 
 void
@@ -139,11 +118,14 @@ resetPeripherals(void)
     SysCtlPeripheralReset (LEFT_BUT_PERIPH);      // LEFT button GPIO
     SysCtlPeripheralReset (RIGHT_BUT_PERIPH);     // RIGHT button GPIO
     SysCtlPeripheralReset (SYSCTL_PERIPH_ADC0);   // Reset ADC
+    SysCtlPeripheralReset (HEIGHT_TIMER_PERIPH);  // ADC trigger timer
+    SysCtlPeripheralReset (SYSCTL_PERIPH_TIMER1); // Control loop timer
+    SysCtlPeripheralReset (TIMING_TIMER_PERIPH);  // Timestamp timer
 }
 
 void
 initClock (void)
-/* Initiliase system clock pulse for timing of background processes, and triggering ADC interrupt using SysTickInterrupt
+/* Initiliase system clock pulse for timing of background processes using SysTickInterrupt
  *
  */
 {
@@ -155,7 +137,7 @@ initClock (void)
     SysCtlPWMClockSet(PWM_DIVIDER_CODE);
     // Set up the period for the SysTick timer.  The SysTick timer period is
     // set as a function of the system clock.
-    SysTickPeriodSet(SysCtlClockGet() / SAMPLE_RATE_HZ);
+    SysTickPeriodSet(SYSTICK_PERIOD_CYCLES);
     //
     // Register the interrupt handler
     SysTickIntRegister(SysTickIntHandler);
@@ -165,59 +147,30 @@ initClock (void)
     SysTickEnable();
 }
 
-void
-initADC (void)
-/* Initialise ADC read from AIN9 for detecting helicopter altitude from sensor. Analogue values from AIN9 is converted to
- * digital value with resolution 1.24 bits per mV resolution (2^12 bits for voltage range of 3,300 mV)
- */
-{
-    //
-    // The ADC0 peripheral must be enabled for configuration and use.
-    SysCtlPeripheralEnable(SYSCTL_PERIPH_ADC0);
-    // Enable sample sequence 3 with a processor signal trigger.  Sequence 3
-    // will do a single sample when the processor sends a signal to start the
-    // conversion.
-    ADCSequenceConfigure(ADC0_BASE, 3, ADC_TRIGGER_PROCESSOR, 0);
-    // Configure step 0 on sequence 3.  Sample channel 0 (ADC_CTL_CH9) in
-    // single-ended mode (default) and configure the interrupt flag
-    // (ADC_CTL_IE) to be set when the sample is done.  Tell the ADC logic
-    // that this is the last conversion on sequence 3 (ADC_CTL_END).  Sequence
-    // 3 has only one programmable step.  Sequence 1 and 2 have 4 steps, and
-    // sequence 0 has 8 programmable steps.
-    ADCSequenceStepConfigure(ADC0_BASE, 3, 0, ADC_CTL_CH9 | ADC_CTL_IE | ADC_CTL_END);
-    // Since sample sequence 3 is now configured, it must be enabled.
-    ADCSequenceEnable(ADC0_BASE, 3);
-    // Register the interrupt handler
-    ADCIntRegister (ADC0_BASE, 3, ADCIntHandler);
-    // Enable interrupts for ADC0 sequence 3 (clears any outstanding interrupts)
-    ADCIntEnable(ADC0_BASE, 3);
-}
-
-
 void calcHeightADC (void)
-/* Take the contents of the altitude sensor circular buffer and calculate the average ADC value
- * for average heli height
+/* Take the running mean of the altitude sensor circular buffer as the average ADC value
+ * for average heli height. The buffer keeps a running sum, so this costs the same regardless of BUF_SIZE
  */
 {
-    uint32_t sum = 0;
-    uint16_t i;
-    //Sum current values of circular buffer
-    for (i = 0; i < BUF_SIZE; i++)
-        sum = sum + readCircBuf (&g_inBuffer);
-    //Calculate mean digital valyue for height from circular buffer
-    currentHeightADC = (2 * sum + BUF_SIZE) / 2 / BUF_SIZE;
+    PROFILE_START(PROFILE_CALC_HEIGHT);
+    currentHeightADC = getHeightADC();
+    currentHeightRate = getHeightRate();
+    PROFILE_END(PROFILE_CALC_HEIGHT);
 }
 
 void
 initHeli(void)
-/*Take sample of current height at initialisation and update landed ADC value
- *
+/*Take sample of current height at initialisation and update landed ADC value. Sampling runs in the background from
+ * start up, so wait for a full buffer first; the mean of a part filled buffer reads low
  */
 {
     initYaw();
     initMainPWM ();
     initTailPWM ();
     enablePWMOutput();
+    while (!heightBufferFull()) {
+        SysCtlSleep();
+    }
     calcHeightADC();
     landedHeight = currentHeightADC;
 }
@@ -244,34 +197,108 @@ initSW1(void)
 void
 updateDisplay(uint16_t PWMMain, uint16_t PWMTail)
 /* Display heli rig values on OLED display. Show Target height, target yaw, and
- * duty cycles of main and tail rotors
+ * duty cycles of main and tail rotors. Each line is only formatted when its value
+ * has changed, and only the changed characters are sent to the display
  */
 {
+    //Values on the display, starting out of range so the first update draws every line
+    static int32_t shownHeight = -1;
+    static int32_t shownYaw = INT32_MIN;
+    static int32_t shownMain = -1;
+    static int32_t shownTail = -1;
 	char string[17];  // 16 characters across the display
     // Form a new string for the line.  The maximum width specified for the
     //  number field ensures it is displayed right justified.
     // Update line on display.
 
-	usnprintf (string, sizeof(string), "Height = %4d%c", targetHeight, '%');
-    OLEDStringDraw (string, 0, 0);
-    usnprintf (string, sizeof(string), "Yaw = %4d", targetYaw);
-    OLEDStringDraw (string, 0, 1);
-    //Display current yaw
-    usnprintf (string, sizeof(string), "Main PWM = %4d%c", PWMMain, '%');
-    OLEDStringDraw (string, 0, 2);
-    //Display target yaw
-    usnprintf (string, sizeof(string), "Tail PWM = %4d%c", PWMTail, '%');
-    OLEDStringDraw (string, 0, 3);
+    if (targetHeight != shownHeight) {
+        usnprintf (string, sizeof(string), "Height = %4d%c", targetHeight, '%');
+        displayLine (string, 0);
+        shownHeight = targetHeight;
+    }
+    if (targetYaw != shownYaw) {
+        usnprintf (string, sizeof(string), "Yaw = %4d", targetYaw);
+        displayLine (string, 1);
+        shownYaw = targetYaw;
+    }
+    //Display main duty
+    if (PWMMain != shownMain) {
+        usnprintf (string, sizeof(string), "Main PWM %3d.%02d%c",
+                   PWMMain / PWM_PERCENT(1), PWMMain % PWM_PERCENT(1), '%');
+        displayLine (string, 2);
+        shownMain = PWMMain;
+    }
+    //Display tail duty
+    if (PWMTail != shownTail) {
+        usnprintf (string, sizeof(string), "Tail PWM %3d.%02d%c",
+                   PWMTail / PWM_PERCENT(1), PWMTail % PWM_PERCENT(1), '%');
+        displayLine (string, 3);
+        shownTail = PWMTail;
+    }
 }
 
+#ifdef TELEMETRY_BINARY
+void
+updateSerial(uint16_t PWMMain, uint16_t PWMTail)
+/* Send one binary telemetry frame to the uart serial terminal, with the same values as the text report
+ * and a timestamp. Decoded on the host by host/telemetryDecode
+ */
+{
+    telemetry_t sample;
+    uint8_t frame[TELEMETRY_FRAME_MAX];
+
+    sample.timeMs = getUptimeMs();
+    sample.height = currentHeight;
+    sample.targetHeight = targetHeight;
+    sample.yaw = currentYaw;
+    sample.targetYaw = targetYaw;
+    sample.dutyMain = PWMMain;
+    sample.dutyTail = PWMTail;
+    sample.flightMode = flightMode;
+    UARTSendBytes (frame, telemetryEncode (&sample, frame));
+}
+
+//Each frame must be on the line before the next is queued
+TIMING_ASSERT(TELEMETRY_FRAME_MAX * UART_BITS_PER_BYTE * CONTROL_RATE_HZ <= BAUD_RATE, telemetryNeedsFasterBaudRate);
+#else
+//Upper bound on the length of a text report line, taking each number at its widest
+#define REPORT_NUMBER_WIDTH 11  //"-2147483648"
+#define REPORT_LINE(format, numbers) (sizeof(format) - 1 + (numbers) * REPORT_NUMBER_WIDTH)
+#ifdef HEIGHT_ADC_JITTER
+#define REPORT_JITTER_MAX (REPORT_LINE("Sample Period = %d to %d of %d cycles\n", 3) \
+                           + REPORT_LINE("Period Bins =\n", 0) + JITTER_BINS * REPORT_LINE(" %d", 1))
+#else
+#define REPORT_JITTER_MAX 0
+#endif
+#define REPORT_MAX (REPORT_LINE("Current Height = %d%c\n", 2) + REPORT_LINE("Target Height = %d%c\n", 2) \
+                    + REPORT_LINE("Current Yaw = %d\n", 1) + REPORT_LINE("Target Yaw = %d\n", 1) \
+                    + REPORT_LINE("Main Duty = %d.%02d%c\n", 3) + REPORT_LINE("Tail Duty = %d.%02d%c\n", 3) \
+                    + REPORT_LINE("Flight Mode = %d\n", 1) + REPORT_LINE("Yaw Edges/s = %d\n", 1) \
+                    + REPORT_LINE("Yaw Errors = %d\n", 1) + REPORT_LINE("CPU Load = %d%c\n", 2) \
+                    + REPORT_LINE("Overruns = %d\n", 1) + REPORT_LINE("Serial Drops = %d\n", 1) \
+                    + REPORT_LINE("Rates Hz = %d.%d/%d.%d/%d.%d of %d/%d/%d\n", 9) + REPORT_JITTER_MAX)
+
+//A report is queued all at once, so the transmit queue must hold the longest
+TIMING_ASSERT(REPORT_MAX <= UART_TX_BUF_SIZE, reportFitsTxQueue);
+
+//Slow ticks between reports, so the line carries the longest report before the next is queued: every third slow
+//tick at the default 9600 baud, and every one at 115200
+#define REPORT_TICKS ((REPORT_MAX * UART_BITS_PER_BYTE * SLOWTICK_RATE_HZ + BAUD_RATE - 1) / BAUD_RATE)
+
 void
 updateSerial(uint16_t PWMMain, uint16_t PWMTail)
 /* Send information to uart serial terminal
  * Send target and current heights in %, current and target yaw in degrees, flight mode,
- * and duty cycles of main and tail rotors
+ * duty cycles of main and tail rotors, encoder edge rate and error count, CPU load, characters the serial transmit
+ * queue has dropped, and the achieved sample, control and slow tick rates against the configured ones. The HEIGHT_ADC_JITTER build adds the spread of periods between altitude
+ * samples since the last report, and their distribution in JITTER_BIN_CYCLES bins about HEIGHT_CONVERSION_CYCLES
  */
 {
     char string[MAX_STR_LEN] = "";
+#ifdef HEIGHT_ADC_JITTER
+    sampleJitter_t jitter;
+    uint8_t bin;
+#endif
     usprintf (string, "Current Height = %d%c\n", currentHeight, '%');
     UARTSend (string);
     usprintf (string, "Target Height = %d%c\n", targetHeight, '%');
@@ -280,13 +307,43 @@ updateSerial(uint16_t PWMMain, uint16_t PWMTail)
     UARTSend (string);
     usprintf (string, "Target Yaw = %d\n", targetYaw);
     UARTSend (string);
-    usprintf (string, "Main Duty = %d%c\n", PWMMain, '%');
+    usprintf (string, "Main Duty = %d.%02d%c\n", PWMMain / PWM_PERCENT(1), PWMMain % PWM_PERCENT(1), '%');
     UARTSend (string);
-    usprintf (string, "Tail Duty = %d%c\n", PWMTail, '%');
+    usprintf (string, "Tail Duty = %d.%02d%c\n", PWMTail / PWM_PERCENT(1), PWMTail % PWM_PERCENT(1), '%');
     UARTSend (string);
     usprintf (string, "Flight Mode = %d\n", flightMode);
     UARTSend (string);
+    usprintf (string, "Yaw Edges/s = %d\n", getYawEdgeRate(SLOWTICK_RATE_HZ) / REPORT_TICKS);
+    UARTSend (string);
+    usprintf (string, "Yaw Errors = %d\n", getYawErrorCount());
+    UARTSend (string);
+    usprintf (string, "CPU Load = %d%c\n", getSchedulerLoad(), '%');
+    UARTSend (string);
+    usprintf (string, "Overruns = %d\n", getSchedulerOverruns());
+    UARTSend (string);
+    usprintf (string, "Serial Drops = %d\n", getUARTDropCount());
+    UARTSend (string);
+    usprintf (string, "Rates Hz = %d.%d/%d.%d/%d.%d of %d/%d/%d\n",
+              getMeasuredRate(TIMING_SAMPLE) / 10, getMeasuredRate(TIMING_SAMPLE) % 10,
+              getMeasuredRate(TIMING_CONTROL) / 10, getMeasuredRate(TIMING_CONTROL) % 10,
+              getMeasuredRate(TIMING_SLOW) / 10, getMeasuredRate(TIMING_SLOW) % 10,
+              getConfiguredRate(TIMING_SAMPLE) / 10, getConfiguredRate(TIMING_CONTROL) / 10,
+              getConfiguredRate(TIMING_SLOW) / 10);
+    UARTSend (string);
+#ifdef HEIGHT_ADC_JITTER
+    getSampleJitter (&jitter);
+    usprintf (string, "Sample Period = %d to %d of %d cycles\n", jitter.minPeriod, jitter.maxPeriod,
+              HEIGHT_CONVERSION_CYCLES);
+    UARTSend (string);
+    UARTSend ("Period Bins =");
+    for (bin = 0; bin < JITTER_BINS; bin++) {
+        usprintf (string, " %d", jitter.bins[bin]);
+        UARTSend (string);
+    }
+    UARTSend ("\n");
+#endif
 }
+#endif
 
 //
 void
@@ -337,25 +394,33 @@ getHeliPos(void)
 
     //Convert current yaw count in encoder pulses to degrees
     currentYaw = getCurrentYaw() * ANGLE_CONVERSION;
+    currentYawRate = getYawRate() * ANGLE_CONVERSION;
 
 }
 
 void
-runHeli(void)
-/* Main helicopter run function, sending updated info to serial output and OLED display, and update PWM duty cycles of Main and Tail
- * rotors every 4 Hz
+SchedulerIntHandler(void)
+/* ISR triggered by Timer1A at CONTROL_RATE_HZ. Release the scheduler tasks that are due
  */
 {
-    uint16_t PWMTail;
-    uint16_t PWMMain;
-
-    if (slowTick) {
-        PWMMain = PIDMainControl(currentHeightADC, targetHeightADC, landedHeight);
-        PWMTail = PIDTailControl(targetYaw, currentYaw);
-        updateSerial(PWMMain, PWMTail);
-        updateDisplay(PWMMain, PWMTail);
-        slowTick = false;
-    }
+    PROFILE_START(PROFILE_SCHED_ISR);
+    TimerIntClear(TIMER1_BASE, TIMER_TIMA_TIMEOUT);
+    countTiming(TIMING_CONTROL, 1);
+    schedulerTick();
+    PROFILE_END(PROFILE_SCHED_ISR);
+}
+
+void
+initSchedulerTimer (void)
+/* Initialise Timer1A as a periodic interrupt at CONTROL_RATE_HZ, the scheduler tick
+ */
+{
+    SysCtlPeripheralEnable(SYSCTL_PERIPH_TIMER1);
+    TimerConfigure(TIMER1_BASE, TIMER_CFG_PERIODIC);
+    TimerLoadSet(TIMER1_BASE, TIMER_A, CONTROL_PERIOD_CYCLES - 1);
+    TimerIntRegister(TIMER1_BASE, TIMER_A, SchedulerIntHandler);
+    TimerIntEnable(TIMER1_BASE, TIMER_TIMA_TIMEOUT);
+    TimerEnable(TIMER1_BASE, TIMER_A);
 }
 
 void
@@ -364,13 +429,15 @@ initPeripherals(void)
  */
 {
     initClock ();
-    initADC ();
-    initCircBuf (&g_inBuffer, BUF_SIZE);
-    OLEDInitialise ();
+    initTiming ();
+    initHeightADC ();
+    initDisplay ();
     initButtons ();
     initSW1();
     initialiseUSB_UART();
     initHeli();
+    initCPUCycles();
+    initSchedulerTimer();
 }
 
 void
@@ -399,31 +466,146 @@ heliLanding(void)
    //Check heli state if below 3% height and reference yaw orientation with in +/- 5 encoder counts
    if (currentHeight <= 3 && (currentYaw < 5 && currentYaw > -5)) {
        //Turn off main and tail motors
+       controlActive = false;
+       homingActive = false;
        setPWMMain(0);
        setPWMTail(0);
        //Set landed flag to true to reenable SW1 interrupt
        landed = true;
    } else {
-       //Update OLED and serial output at 4Hz, and update PWM of motors at 4Hz
-       runHeli();
+       //Let the controllers land the heli
+       homingActive = false;
+       controlActive = true;
    }
 }
 
 void
 flySortie(void)
 /* Program for running sortie of project once in flying state (flightMode = 1). Find home position if the reference ISR has
- * not occured, otherwise poll buttons regularly and run main helirun function
+ * not occured, otherwise hand the rotors to the controllers
  */
 {
     if (!isHomed()) { //If home signal not detected via ISR
-        setPWMTail(15); //Slowly rotate heli until reference pulse detected
-        setPWMMain(30);
+        controlActive = false;
+        if (!homingActive) {
+            resetYawRateControl(); //Start the spin from the open loop duty
+        }
+        homingActive = true; //Rotate heli at HOMING_YAW_RATE until reference pulse detected
+        setPWMMain(PWM_PERCENT(HOMING_MAIN_DUTY));
     } else {
+        homingActive = false;
+        controlActive = true;
+    }
+}
+
+//*****************************************************************************
+// Scheduler tasks, run from schedulerRun() when released by the Timer1A tick
+//*****************************************************************************
+void
+estimationTask(void)
+/* Update the height and yaw estimates and the target height in ADC counts
+ */
+{
+    setHeightCommand((uint16_t)getPWMMain());
+    getHeliPos();
+    targetHeightADC = landedHeight - (targetHeight*RANGE_ADC)/100;
+}
+
+void
+controlTask(void)
+/* Run both controllers when the flight mode logic allows it, or the tail rate loop while homing. Released every tick,
+ * so they run at the rate matching DELTA_T
+ */
+{
+    if (controlActive) {
+        PROFILE_START(PROFILE_PID_MAIN);
+        dutyMain = PIDMainControl(currentHeightADC, targetHeightADC, landedHeight, currentHeightRate);
+        PROFILE_END(PROFILE_PID_MAIN);
+        PROFILE_START(PROFILE_PID_TAIL);
+        dutyTail = PIDTailControl(targetYaw, currentYaw, currentYawRate);
+        PROFILE_END(PROFILE_PID_TAIL);
+    } else if (homingActive) {
+        dutyTail = PIDYawRateControl(HOMING_YAW_RATE, currentYawRate);
+    }
+}
+
+void
+flightTask(void)
+/* Run the landing or sortie logic for the current flight mode
+ */
+{
+    switch (flightMode)
+    {
+    case 0:
+        heliLanding(); //If flightmode is 0, begin landing
+        break;
+    case 1:
+        flySortie(); //If flightmode is 1, run sortie
+        break;
+    }
+}
+
+void
+buttonTask(void)
+/* Poll the buttons while flying a sortie once the heli has found its home position
+ */
+{
+    if (flightMode == 1 && isHomed()) {
         pollButtons();
-        runHeli();
     }
 }
 
+void
+displayTask(void)
+/* Update the display, and the rate self-measurement, at SLOWTICK_RATE_HZ
+ */
+{
+    countTiming(TIMING_SLOW, 1);
+    updateTiming();
+    updateDisplay(dutyMain, dutyTail);
+}
+
+void
+serialTask(void)
+/* Send the serial report. With profiling built in, a PROFILE_DUMP_CHAR received over serial starts a dump of the
+ * profile statistics, sent one region per run after the report, and a PROFILE_RESET_CHAR clears them
+ */
+{
+#ifdef PROFILE_ENABLE
+    static bool dumping = false;
+    int32_t command = UARTReceive();
+
+    if (command == PROFILE_DUMP_CHAR) {
+        dumping = true;
+    } else if (command == PROFILE_RESET_CHAR) {
+        profileReset();
+    }
+#endif
+    PROFILE_START(PROFILE_SERIAL);
+    updateSerial(dutyMain, dutyTail);
+    PROFILE_END(PROFILE_SERIAL);
+#ifdef PROFILE_ENABLE
+    if (dumping) {
+        dumping = !profileDump();
+    }
+#endif
+}
+
+//Task table. Period and phase are in ticks of CONTROL_RATE_HZ, budget in CPU cycles at 20 MHz
+static task_t heliTasks[] = {
+    // run              period              phase   priority    budget
+    { estimationTask,   1,                  0,      0,          2000 },
+    { controlTask,      1,                  0,      1,          4000 },
+    { flightTask,       2,                  0,      2,          2000 },
+    { buttonTask,       2,                  1,      3,          2000 },
+#ifdef TELEMETRY_BINARY
+    { serialTask,       1,                  0,      4,          4000 },  //Log every control period
+#else
+    { serialTask,       SLOW_TASK_PERIOD * REPORT_TICKS, SLOW_TASK_PERIOD / 2, 4, 20000 },
+#endif
+    { displayTask,      SLOW_TASK_PERIOD,   0,      5,          40000 },
+};
+
 /***********************************************
  * Start main program
 ***********************************************/
@@ -432,23 +614,11 @@ int main(void)
     //Reset and initialise all required peripherals and initial values
     resetPeripherals();
     initPeripherals();
+    initScheduler(heliTasks, sizeof(heliTasks) / sizeof(heliTasks[0]));
 
     // Enable interrupts to the processor.
     IntMasterEnable();
 
-    //Start kernel
-    while(1)
-    {
-        getHeliPos();
-        targetHeightADC = landedHeight - (targetHeight*RANGE_ADC)/100;
-        switch (flightMode)
-        {
-        case 0:
-            heliLanding(); //If flightmode is 0, begin landing
-            break;
-        case 1:
-            flySortie(); //If flightmode is 1, run sortie
-            break;
-        }
-	}
+    //Start kernel, never returns
+    schedulerRun();
 }
@@ -3,7 +3,8 @@
  * PIDController.c
  *
  * PID controller module for controlling helicopter rig main and tail rotor duty
- * cycles. Main rotor uses a PID controller, tail rotor uses a PI controller.
+ * cycles. Both rotors use a PID controller, with the D term on the estimated
+ * rate. The tail also has a rate controller for the homing spin.
  *
  * Created by: Ben Tait
  * Last modified: 30/05/2019
@@ -25,79 +26,290 @@
 #include "motorControl.h"
 #include "PIDController.h"
 
-//Global error values for use in PID controllers
-static int32_t      errorI = 0;
-static int32_t      errorI_t = 0;
-static double       pastError;
-static double       pastError_t;
+#ifdef PID_TUNABLE
+#ifdef PID_USE_FLOAT
+//Gains, set by setPIDGains()
+static double       gainP = KP;
+static double       gainI = KI;
+static double       gainD = KD;
+static double       gainP_t = KP_t;
+static double       gainI_t = KI_t;
+static double       gainD_t = KD_t;
+#else
+//Gains in fixed point, set by setPIDGains(). Converted there once, so the controllers do no double arithmetic
+static int32_t      gainP_q = PID_Q(KP);
+static int32_t      gainI_q = PID_Q(KI);
+static int32_t      gainD_q = PID_Q(KD);
+static int32_t      gainP_t_q = PID_Q(KP_t);
+static int32_t      gainI_t_q = PID_Q(KI_t);
+static int32_t      gainD_t_q = PID_Q(KD_t);
+#endif
+
+void
+setPIDGains(double kp, double ki, double kd, double kpTail, double kiTail, double kdTail)
+/* Change the controller gains. Takes effect from the next control period
+ */
+{
+#ifdef PID_USE_FLOAT
+    gainP = kp;
+    gainI = ki;
+    gainD = kd;
+    gainP_t = kpTail;
+    gainI_t = kiTail;
+    gainD_t = kdTail;
+#else
+    gainP_q = PID_Q(kp);
+    gainI_q = PID_Q(ki);
+    gainD_q = PID_Q(kd);
+    gainP_t_q = PID_Q(kpTail);
+    gainI_t_q = PID_Q(kiTail);
+    gainD_t_q = PID_Q(kdTail);
+#endif
+}
+#else
+#define gainP       KP
+#define gainI       KI
+#define gainD       KD
+#define gainP_t     KP_t
+#define gainI_t     KI_t
+#define gainD_t     KD_t
+#endif
+
+//The gains give duty in percent; the PWM driver takes parts per PWM_DUTY_SCALE
+#define DUTY_PER_PERCENT (PWM_DUTY_SCALE / 100)
+#define DUTY_MIN PWM_PERCENT(2)
+#define DUTY_MAX PWM_PERCENT(98)
+
+//Homing rate loop gains and time step in fixed point
+#define KP_HOMING_Q PID_Q(KP_HOMING)
+#define KI_HOMING_Q PID_Q(KI_HOMING * DELTA_T)
+
+//Tail duty of the homing spin, fixed point percent
+static int32_t      homingDuty = PID_Q(HOMING_TAIL_DUTY);
+
+static uint16_t
+limitDuty(int64_t output)
+/* Convert a fixed-point controller output in percent to a duty in parts per PWM_DUTY_SCALE, limited to between
+ * 2% and 98%
+ */
+{
+    if (output >= ((int64_t)98 << PID_Q_BITS)) {
+        return DUTY_MAX;
+    }
+    if (output <= ((int64_t)2 << PID_Q_BITS)) {
+        return DUTY_MIN;
+    }
+    return (uint16_t)((output * DUTY_PER_PERCENT) >> PID_Q_BITS);
+}
+
+uint16_t
+PIDYawRateControl(int16_t targetRate, int16_t yawRate)
+/* Tail rotor PI controller on yaw rate in degrees per second, for the homing spin. The integral starts from
+ * HOMING_TAIL_DUTY, the open loop duty it replaces, so the spin starts as before and then holds targetRate
+ * whatever the main rotor torque. Limit PWM output to between 2% and 98%, and return it in parts per PWM_DUTY_SCALE
+ */
+{
+    int32_t error = (int32_t)targetRate - yawRate;
+    uint16_t duty;
+
+    homingDuty += error * KI_HOMING_Q;
+    if (homingDuty > PID_Q(98)) {
+        homingDuty = PID_Q(98);
+    } else if (homingDuty < PID_Q(2)) {
+        homingDuty = PID_Q(2);
+    }
+    duty = limitDuty((int64_t)homingDuty + (int64_t)error * KP_HOMING_Q);
+    setPWMTail(duty);
+    return duty;
+}
+
+void
+resetYawRateControl(void)
+/* Restart the homing rate loop integral from HOMING_TAIL_DUTY. Called each time homing starts, so a spin never
+ * inherits the duty a previous one wound up to
+ */
+{
+    homingDuty = PID_Q(HOMING_TAIL_DUTY);
+}
+
+#ifdef PID_USE_FLOAT
+//Global error values for use in PID controllers. Integral errors keep their fraction, as each
+//error * DELTA_T step is well under one count at the control rate
+static double       errorI = 0;
+static double       errorI_t = 0;
 static int32_t      errorD;
 static int32_t      errorD_t;
 
 uint16_t
-PIDMainControl(uint16_t currentHeight, uint16_t targetHeight, uint16_t landedHeight)
+PIDMainControl(uint16_t currentHeight, uint16_t targetHeight, uint16_t landedHeight, int32_t heightRate)
 /* Main rotor PID controller. Take current heli height parameters and calculate the required error values.
+ * The D term acts on heightRate, the estimated rate of change of currentHeight in ADC counts per second, rather
+ * than on the change in error, so it is as clean as the estimate and does not kick when the target steps.
  * Save a running sum of the integral error for use in the I controller. Because the I component of the controller must
  * create a continuous positive PWM signal to hold a constant altitude, error I is bounded to values above 0.
  * Limit PWM output to between 2% and 98% before being applied to the set PWM function.
- * Calculated duty is returned for displaying on the OLED and serial output
+ * Calculated duty, in parts per PWM_DUTY_SCALE, is returned for displaying on the OLED and serial output
  */
 {
     uint16_t PWMMain;
     double error; //Error signal between current height and target height
+    double output;
 
     error = currentHeight - targetHeight; //Positive if going upwards
-    errorI += error * DELTA_T; //integrate error every 0.25 seconds (change magic number eventually)
+    errorI += error * DELTA_T; //integrate error every control period
 
 
     //Boundary condition to prevent negative contributing integral error
     if (errorI <= 0) {
         errorI = 0;
     }
-    errorD = (pastError - error)/DELTA_T;
+    errorD = -heightRate; //(pastError - error) / DELTA_T for a steady target
 
-    PWMMain = errorI*KI + error*KP - errorD*KD;
+    output = (errorI*gainI + error*gainP - errorD*gainD) * DUTY_PER_PERCENT;
 
-    if (PWMMain >= 98) {
-        PWMMain = 98;
+    if (output >= DUTY_MAX) {
+        output = DUTY_MAX;
     }
-    if (PWMMain <= 2) {
-        PWMMain = 2;
+    if (output <= DUTY_MIN) {
+        output = DUTY_MIN;
     }
+    PWMMain = output;
 
     setPWMMain(PWMMain);
-    pastError = error;
     return PWMMain;
 }
 
 uint16_t
-PIDTailControl(int16_t targetYaw, int16_t currentYaw)
+PIDTailControl(int16_t targetYaw, int16_t currentYaw, int16_t yawRate)
 /* Tail rotor PID controller. Take current yaw parameters and calculate the required error values.
+ * The D term acts on yawRate, the measured yaw rate in degrees per second, so it does not kick when the target steps.
  * Save a running sum of the integral error for use in the I controller. Because the I component of the controller must
  * create a continuous positive PWM signal to counter torque produced by the main rotor output, error I is bounded to values above 0.
  * Limit PWM output to between 2% and 98% before being applied to the set PWM function.
- * Calculated duty is returned for displaying on the OLED and serial output
+ * Calculated duty, in parts per PWM_DUTY_SCALE, is returned for displaying on the OLED and serial output
  */
 {
     uint16_t PWMTail;
     double error; //Error signal between current height and target height
+    double output;
     error = targetYaw - currentYaw;     //Error in yaw in degrees
-    errorI_t = errorI_t + error * DELTA_T; //integrate error every 0.1 seconds (change magic number eventually)
+    errorI_t = errorI_t + error * DELTA_T; //integrate error every control period
 
     //Boundary condition to prevent negative contributing integral error
     if (errorI_t <= 0) {
         errorI_t = 0;
     }
 
-    PWMTail = errorI_t*KI_t + error*KP_t;
+    errorD_t = -yawRate; //Rate of the error, for a steady target
+
+    output = (errorI_t*gainI_t + error*gainP_t + errorD_t*gainD_t) * DUTY_PER_PERCENT;
 
-    if (PWMTail >= 98) {
-        PWMTail = 98;
+    if (output >= DUTY_MAX) {
+        output = DUTY_MAX;
     }
-    if (PWMTail <= 2) {
-        PWMTail = 2;
+    if (output <= DUTY_MIN) {
+        output = DUTY_MIN;
     }
+    PWMTail = output;
     setPWMTail(PWMTail);
-    pastError_t = error;
     return PWMTail;
 }
+#else
+//Gains and time step in fixed point. Constants unless PID_TUNABLE
+#ifdef PID_TUNABLE
+#define KP_Q        gainP_q
+#define KI_Q        gainI_q
+#define KD_Q        gainD_q
+#define KP_T_Q      gainP_t_q
+#define KI_T_Q      gainI_t_q
+#define KD_T_Q      gainD_t_q
+#else
+#define KP_Q        PID_Q(gainP)
+#define KI_Q        PID_Q(gainI)
+#define KD_Q        PID_Q(gainD)
+#define KP_T_Q      PID_Q(gainP_t)
+#define KI_T_Q      PID_Q(gainI_t)
+#define KD_T_Q      PID_Q(gainD_t)
+#endif
+#define DELTA_T_Q   PID_Q(DELTA_T)
+
+//Global error values for use in PID controllers. Integral errors are fixed point, as each error * DELTA_T
+//step is well under one count at the control rate. Others are whole ADC counts or degrees
+static int32_t      errorI = 0;
+static int32_t      errorI_t = 0;
+
+static int32_t
+saturate(int64_t value)
+/* Clamp a 64 bit intermediate result to the int32_t range
+ */
+{
+    if (value > INT32_MAX) {
+        return INT32_MAX;
+    }
+    if (value < INT32_MIN) {
+        return INT32_MIN;
+    }
+    return (int32_t)value;
+}
 
+uint16_t
+PIDMainControl(uint16_t currentHeight, uint16_t targetHeight, uint16_t landedHeight, int32_t heightRate)
+/* Main rotor PID controller in fixed point. Take current heli height parameters and calculate the required error values.
+ * The D term acts on heightRate, the estimated rate of change of currentHeight in ADC counts per second, rather
+ * than on the change in error, so it is as clean as the estimate and does not kick when the target steps.
+ * Save a running sum of the integral error for use in the I controller. Because the I component of the controller must
+ * create a continuous positive PWM signal to hold a constant altitude, error I is bounded to values above 0.
+ * Limit PWM output to between 2% and 98% before being applied to the set PWM function.
+ * Calculated duty, in parts per PWM_DUTY_SCALE, is returned for displaying on the OLED and serial output
+ */
+{
+    uint16_t PWMMain;
+    int32_t error; //Error signal between current height and target height
+    int32_t errorD;
+    int64_t output;
+
+    error = (int32_t)currentHeight - targetHeight; //Positive if going upwards
+    errorI = saturate((int64_t)errorI + (int64_t)error * DELTA_T_Q);
+
+    //Boundary condition to prevent negative contributing integral error
+    if (errorI <= 0) {
+        errorI = 0;
+    }
+    errorD = -heightRate; //(pastError - error) / DELTA_T for a steady target
+
+    output = (((int64_t)errorI * KI_Q) >> PID_Q_BITS) + (int64_t)error * KP_Q - (int64_t)errorD * KD_Q;
+    PWMMain = limitDuty(output);
+
+    setPWMMain(PWMMain);
+    return PWMMain;
+}
+
+uint16_t
+PIDTailControl(int16_t targetYaw, int16_t currentYaw, int16_t yawRate)
+/* Tail rotor PID controller in fixed point. Take current yaw parameters and calculate the required error values.
+ * The D term acts on yawRate, the measured yaw rate in degrees per second, so it does not kick when the target steps.
+ * Save a running sum of the integral error for use in the I controller. Because the I component of the controller must
+ * create a continuous positive PWM signal to counter torque produced by the main rotor output, error I is bounded to values above 0.
+ * Limit PWM output to between 2% and 98% before being applied to the set PWM function.
+ * Calculated duty, in parts per PWM_DUTY_SCALE, is returned for displaying on the OLED and serial output
+ */
+{
+    uint16_t PWMTail;
+    int32_t error; //Error signal between current yaw and target yaw
+    int64_t output;
+
+    error = (int32_t)targetYaw - currentYaw;     //Error in yaw in degrees
+    errorI_t = saturate((int64_t)errorI_t + (int64_t)error * DELTA_T_Q);
+
+    //Boundary condition to prevent negative contributing integral error
+    if (errorI_t <= 0) {
+        errorI_t = 0;
+    }
+
+    output = (((int64_t)errorI_t * KI_T_Q) >> PID_Q_BITS) + (int64_t)error * KP_T_Q - (int64_t)yawRate * KD_T_Q;
+    PWMTail = limitDuty(output);
+
+    setPWMTail(PWMTail);
+    return PWMTail;
+}
+#endif
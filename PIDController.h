@@ -3,7 +3,8 @@
  * PIDController.h
  *
  * PID controller module for controlling helicopter rig main and tail rotor duty
- * cycles. Main rotor uses a PID controller, tail rotor uses a PI controller.
+ * cycles. Both rotors use a PID controller, with the D term on the estimated
+ * rate. The tail also has a rate controller for the homing spin.
  *
  * Created by: Ben Tait
  * Last modified: 30/05/2019
@@ -14,24 +15,47 @@
 #include <stdint.h>
 #include <stdbool.h>
 
-//Main Controller Gains
-#define KP 0.01
-#define KI 0.01
-#define KD 0.01
+//Controller gains KP, KI, KD, KP_t, KI_t and KD_t
+#include "PIDGains.h"
 
-//Tail Controller Gains
-#define KP_t 0.12
-#define KI_t 0.03
+//CONTROL_RATE_HZ, the rate of the timer interrupt that runs the controllers, and DELTA_T
+#include "timingConfig.h"
 
-#define DELTA_T 0.25
+//Build option: define to use the original double precision controllers as a reference.
+//The default fixed-point controllers give the same duty to within 1%, the difference coming from rounding
+//the gains and DELTA_T to PID_Q_BITS fractional bits
+//#define PID_USE_FLOAT
+
+//Build option: define to hold the gains in variables that setPIDGains() can change at run time, for tuning on the
+//host simulator. Otherwise they are constants, folded into the controller arithmetic
+//#define PID_TUNABLE
+
+//Fixed-point format for gains, time step and integral errors: Q15.16 in an int32_t
+#define PID_Q_BITS 16
+#define PID_Q(x) ((int32_t)((x) * (1L << PID_Q_BITS) + 0.5))   //Rounded constant conversion, folded at compile time
+
+//Homing spin rate loop: the open loop tail duty it starts from (%), and its gains in % duty per degree per second
+//of rate error, and per degree of accumulated error
+#define HOMING_TAIL_DUTY 15
+#define KP_HOMING 0.02
+#define KI_HOMING 0.05
 
 //
 #define RANGE_ADC (SENSOR_VOLTAGE_RANGE*HEIGHT_V_TO_DIGITAL)    //Digital rep of 1V. V per V/digital
 #define SENSOR_VOLTAGE_RANGE 1000                               //Change in sensor voltage for 0% to 100% (1000mV)
 #define HEIGHT_V_TO_DIGITAL 4096/3300                           //Analog voltage to digital altitude sensor output
 
-uint16_t PIDMainControl (uint16_t currentHeightADC, uint16_t targetHeightADC, uint16_t landedHeight);
+uint16_t PIDMainControl (uint16_t currentHeightADC, uint16_t targetHeightADC, uint16_t landedHeight,
+                         int32_t heightRate);
+
+uint16_t PIDTailControl(int16_t targetYaw, int16_t currentYawCount, int16_t yawRate);
+
+uint16_t PIDYawRateControl(int16_t targetRate, int16_t yawRate);
+
+void resetYawRateControl(void);
 
-uint16_t PIDTailControl(int16_t targetYaw, int16_t currentYawCount);
+#ifdef PID_TUNABLE
+void setPIDGains(double kp, double ki, double kd, double kpTail, double kiTail, double kdTail);
+#endif
 
 #endif /*PIDCONTROLLER_H*/
@@ -0,0 +1,22 @@
+/**********************************************************
+ *
+ * PIDGains.h
+ *
+ * Gains for the main and tail rotor controllers in PIDController.
+ * Hand tuned on the rig; host/gainTune writes a replacement for this
+ * file from a search on the simulated rig.
+ **********************************************************/
+#ifndef PIDGAINS_H
+#define PIDGAINS_H
+
+//Main Controller Gains
+#define KP 0.01
+#define KI 0.01
+#define KD 0.01
+
+//Tail Controller Gains. The D term is off until it has been tuned on the rig
+#define KP_t 0.12
+#define KI_t 0.03
+#define KD_t 0
+
+#endif /*PIDGAINS_H*/
@@ -0,0 +1,82 @@
+// *******************************************************
+//
+// cicDecimator.c
+//
+// Cascaded integrator-comb decimator for the oversampled altitude
+// input, in fixed point.
+//
+// *******************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "cicDecimator.h"
+
+static bool
+step(cicDecimator_t *cic, uint32_t sample, uint32_t *output)
+/* Run the integrators on a sample, and the combs if an output is due. Return true with the output, still carrying
+ * the gain of rate^CIC_ORDER, if one was made
+ */
+{
+    uint32_t value = sample;
+    uint32_t comb;
+    uint8_t i;
+
+    for (i = 0; i < CIC_ORDER; i++) {
+        cic->integrator[i] += value;
+        value = cic->integrator[i];
+    }
+    if (++cic->phase < cic->rate) {
+        return false;
+    }
+    cic->phase = 0;
+    for (i = 0; i < CIC_ORDER; i++) {
+        comb = value - cic->delay[i];
+        cic->delay[i] = value;
+        value = comb;
+    }
+    *output = value;
+    return true;
+}
+
+void
+initCIC(cicDecimator_t *cic, uint16_t rate)
+/* Set the decimation rate, a power of two of at least 2. The first sample is taken as the level the input has
+ * always had
+ */
+{
+    uint8_t i;
+
+    cic->rate = rate;
+    cic->shift = 0;
+    while ((1u << (cic->shift / CIC_ORDER)) < rate) {
+        cic->shift += CIC_ORDER;
+    }
+    cic->phase = 0;
+    cic->primed = false;
+    for (i = 0; i < CIC_ORDER; i++) {
+        cic->integrator[i] = 0;
+        cic->delay[i] = 0;
+    }
+}
+
+bool
+updateCIC(cicDecimator_t *cic, uint16_t sample, uint16_t *output)
+/* Take the next ADC sample. Return true with the next output, in ADC counts, once every rate samples
+ */
+{
+    uint32_t value;
+    uint32_t n;
+
+    if (!cic->primed) {
+        //Fill every stage with the first sample, so the output starts there rather than rising from zero
+        for (n = 0; n < (uint32_t)CIC_ORDER * cic->rate; n++) {
+            step(cic, sample, &value);
+        }
+        cic->primed = true;
+    }
+    if (!step(cic, sample, &value)) {
+        return false;
+    }
+    *output = (uint16_t)((value + (1u << (cic->shift - 1))) >> cic->shift);
+    return true;
+}
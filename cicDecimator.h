@@ -0,0 +1,39 @@
+// *******************************************************
+//
+// cicDecimator.h
+//
+// Cascaded integrator-comb decimator for the oversampled altitude
+// input. CIC_ORDER integrators run on every ADC sample and CIC_ORDER
+// combs on every rate'th, giving one output per rate samples with a
+// gain of rate^CIC_ORDER, which is shifted back out so outputs are in
+// ADC counts. The decimation rate must be a power of two for that.
+//
+// All arithmetic is unsigned and allowed to wrap: the combs undo the
+// integrators exactly so long as the output fits in 32 bits, 12 bit
+// samples times rate^CIC_ORDER. The group delay is
+// CIC_ORDER * (rate - 1) / 2 input samples.
+//
+// *******************************************************
+
+#ifndef CICDECIMATOR_H
+#define CICDECIMATOR_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define CIC_ORDER 3                 //Stages; more reject aliases better but add delay
+
+typedef struct {
+    uint32_t integrator[CIC_ORDER];
+    uint32_t delay[CIC_ORDER];      //Input of each comb at the last output
+    uint16_t rate;                  //Inputs per output, a power of two of at least 2
+    uint8_t shift;                  //log2(rate^CIC_ORDER), the gain taken back out
+    uint16_t phase;                 //Inputs since the last output
+    bool primed;                    //A sample has been taken
+} cicDecimator_t;
+
+void initCIC(cicDecimator_t *cic, uint16_t rate);
+
+bool updateCIC(cicDecimator_t *cic, uint16_t sample, uint16_t *output);
+
+#endif /*CICDECIMATOR_H*/
@@ -2,62 +2,179 @@
 // 
 // circBufT.c
 //
-// Support for a circular buffer of uint32_t values on the 
-//  Tiva processor.
+// Support for a circular buffer of uint32_t or uint16_t values
+//  on the Tiva processor.
 // P.J. Bones UCECE
 // Last modified:  8.3.2017
 // 
 // *******************************************************
 
 #include <stdint.h>
+#include <assert.h>
 #include "stdlib.h"
 #include "circBufT.h"
 
+// *******************************************************
+// Memory barrier separating the data accesses from the index
+// that publishes or consumes them.
+#if defined(__TI_COMPILER_VERSION__)
+#define CIRCBUF_BARRIER()   __asm(" dmb")
+#else
+#define CIRCBUF_BARRIER()   __sync_synchronize()
+#endif
+
 // *******************************************************
 // initCircBuf: Initialise the circBuf instance. Reset both indices to
 // the start of the buffer.  Dynamically allocate and clear the the 
 // memory and return a pointer for the data.  Return NULL if 
-// allocation fails.
-uint32_t *
+// allocation fails, or for a window of no entries, which has no mean.
+circBufEntry_t *
 initCircBuf (circBuf_t *buffer, uint32_t size)
 {
 	buffer->windex = 0;
 	buffer->rindex = 0;
 	buffer->size = size;
+	buffer->mask = CIRCBUF_CAPACITY(size) - 1;
+	buffer->sum = 0;
+	buffer->data = NULL;
+	buffer->allocated = true;
+	if (size == 0)
+		return NULL;
 	buffer->data = 
-        (uint32_t *) calloc (size, sizeof(uint32_t));
+        (circBufEntry_t *) calloc (buffer->mask + 1, sizeof(circBufEntry_t));
 	return buffer->data;
 }
    // Note use of calloc() to clear contents.
 
 // *******************************************************
-// writeCircBuf: insert entry at the current windex location,
-// advance windex, modulo (buffer size).
+// initCircBufStatic: Initialise the circBuf instance on caller
+// storage of CIRCBUF_CAPACITY(size) entries, and clear it. The
+// size is fixed at build time, so a window of no entries is a bug.
+circBufEntry_t *
+initCircBufStatic (circBuf_t *buffer, uint32_t size, circBufEntry_t *storage)
+{
+	uint32_t i;
+
+	assert(size > 0);
+	buffer->windex = 0;
+	buffer->rindex = 0;
+	buffer->size = size;
+	buffer->mask = CIRCBUF_CAPACITY(size) - 1;
+	buffer->sum = 0;
+	for (i = 0; i <= buffer->mask; i++)
+		storage[i] = 0;
+	buffer->data = storage;
+	buffer->allocated = false;
+	return storage;
+}
+
+// *******************************************************
+// writeCircBuf: insert entry at the current windex location, then
+// publish it by advancing windex. The running sum is updated by
+// removing the entry leaving the window and adding the new one.
 void
 writeCircBuf (circBuf_t *buffer, uint32_t entry)
 {
-	buffer->data[buffer->windex] = entry;
-	buffer->windex++;
-	if (buffer->windex >= buffer->size)
-	   buffer->windex = 0;
+	uint32_t windex = buffer->windex;
+	circBufEntry_t stored = (circBufEntry_t) entry;	// the sum must match what is kept
+
+	buffer->sum = buffer->sum
+	        - buffer->data[(windex - buffer->size) & buffer->mask] + stored;
+	buffer->data[windex & buffer->mask] = stored;
+	CIRCBUF_BARRIER();	// entry must be visible before it is published
+	buffer->windex = windex + 1;
+}
+
+// *******************************************************
+// writeCircBufN: insert n entries from src and publish them together
+// with a single advance of windex.
+void
+writeCircBufN (circBuf_t *buffer, const uint32_t *src, uint32_t n)
+{
+	uint32_t windex = buffer->windex;
+	uint32_t i;
+	circBufEntry_t stored;
+
+	for (i = 0; i < n; i++, windex++)
+	{
+		stored = (circBufEntry_t) src[i];
+		buffer->sum = buffer->sum
+		        - buffer->data[(windex - buffer->size) & buffer->mask] + stored;
+		buffer->data[windex & buffer->mask] = stored;
+	}
+	CIRCBUF_BARRIER();	// block must be visible before it is published
+	buffer->windex = windex;
 }
 
 // *******************************************************
 // readCircBuf: return entry at the current rindex location,
-// advance rindex, modulo (buffer size). The function deos not check
-// if reading has advanced ahead of writing.
+// advance rindex. The function deos not check if reading has
+// advanced ahead of writing.
 uint32_t
 readCircBuf (circBuf_t *buffer)
 {
 	uint32_t entry;
-	
-	entry = buffer->data[buffer->rindex];
-	buffer->rindex++;
-	if (buffer->rindex >= buffer->size)
-	   buffer->rindex = 0;
+	uint32_t rindex = buffer->rindex;
+
+	CIRCBUF_BARRIER();	// see everything published up to windex
+	entry = buffer->data[rindex & buffer->mask];
+	CIRCBUF_BARRIER();	// finish the read before releasing the slot
+	buffer->rindex = rindex + 1;
     return entry;
 }
 
+// *******************************************************
+// readCircBufN: copy the n most recently published entries, oldest
+// first, into dest. If the writer advanced far enough during the
+// copy to overwrite its first entries, the copy is taken again.
+uint32_t
+readCircBufN (circBuf_t *buffer, uint32_t *dest, uint32_t n)
+{
+	uint32_t windex;
+	uint32_t start;
+	uint32_t i;
+
+	if (n > buffer->size)
+		n = buffer->size;
+	do
+	{
+		windex = buffer->windex;
+		if (n > windex)
+			n = windex;
+		CIRCBUF_BARRIER();
+		start = windex - n;
+		for (i = 0; i < n; i++)
+			dest[i] = buffer->data[(start + i) & buffer->mask];
+		CIRCBUF_BARRIER();
+	} while (buffer->windex - windex > buffer->mask - n);
+	buffer->rindex = windex;
+	return n;
+}
+
+// *******************************************************
+// circBufCount: return the number of published entries not yet
+// consumed, limited to the storage capacity.
+uint32_t
+circBufCount (circBuf_t *buffer)
+{
+	uint32_t count = buffer->windex - buffer->rindex;
+
+	if (count > buffer->mask + 1)
+		count = buffer->mask + 1;
+	return count;
+}
+
+// *******************************************************
+// meanCircBuf: return the rounded mean of the last size entries
+// in constant time, using the running sum kept by writeCircBuf().
+uint32_t
+meanCircBuf (circBuf_t *buffer)
+{
+	uint32_t sum = buffer->sum;	// single read, safe against the writer ISR
+
+	return (2 * sum + buffer->size) / 2 / buffer->size;
+}
+
 // *******************************************************
 // freeCircBuf: Releases the memory allocated to the buffer data,
 // sets pointer to NULL and ohter fields to 0. The buffer can
@@ -68,7 +185,11 @@ freeCircBuf (circBuf_t * buffer)
 	buffer->windex = 0;
 	buffer->rindex = 0;
 	buffer->size = 0;
-	free (buffer->data);
+	buffer->mask = 0;
+	buffer->sum = 0;
+	if (buffer->allocated)
+		free (buffer->data);
 	buffer->data = NULL;
+	buffer->allocated = false;
 }
 
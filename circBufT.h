@@ -5,48 +5,137 @@
 // 
 // circBufT.h
 //
-// Support for a circular buffer of uint32_t values on the 
-//  Tiva processor.
+// Support for a circular buffer of uint32_t or uint16_t values
+//  on the Tiva processor.
 // P.J. Bones UCECE
 // Last modified:  7.3.2017
 // 
+// The buffer is a single-producer/single-consumer ring: one
+// writer (e.g. an ISR) and one reader (e.g. the main loop) may
+// use it concurrently without disabling interrupts. Storage is
+// rounded up to a power of two so indices can be masked, and
+// windex/rindex run freely, wrapping at 2^32.
+//
+// Storage is either supplied by the caller, normally declared with
+// CIRCBUF_STORAGE() so nothing is allocated at run time, or taken
+// from the heap by initCircBuf(). Release builds link with
+// --heap_size=0, so the heap is not an option on the target.
+//
+// Memory for the BUF_SIZE = 50 height buffer (64 entries):
+//   calloc, uint32_t entries          256 heap + 8 heap header
+//   CIRCBUF_STORAGE, uint32_t entries 256 .bss
+//   CIRCBUF_STORAGE, uint16_t entries 128 .bss
+// plus the circBuf_t itself, 28 bytes.
+//
 // *******************************************************
 #include <stdint.h>
+#include <stdbool.h>
+
+// *******************************************************
+// Build option: define to store entries as uint16_t, enough for 12 bit
+// ADC samples in half the memory. Entries are still passed as
+// uint32_t, and are truncated to 16 bits when stored.
+//#define CIRCBUF_ENTRY_16
+
+#ifdef CIRCBUF_ENTRY_16
+typedef uint16_t circBufEntry_t;
+#else
+typedef uint32_t circBufEntry_t;
+#endif
+
+// *******************************************************
+// CIRCBUF_CAPACITY: storage entries for a window of size entries, the
+// next power of two above size, as a constant expression. Each step
+// copies the bits set so far down, so all below the top one are set.
+#define CIRCBUF_SMEAR1(n) ((n) | (n) >> 1)
+#define CIRCBUF_SMEAR2(n) (CIRCBUF_SMEAR1(n) | CIRCBUF_SMEAR1(n) >> 2)
+#define CIRCBUF_SMEAR4(n) (CIRCBUF_SMEAR2(n) | CIRCBUF_SMEAR2(n) >> 4)
+#define CIRCBUF_SMEAR8(n) (CIRCBUF_SMEAR4(n) | CIRCBUF_SMEAR4(n) >> 8)
+#define CIRCBUF_SMEAR(n) (CIRCBUF_SMEAR8(n) | CIRCBUF_SMEAR8(n) >> 16)
+#define CIRCBUF_CAPACITY(size) (CIRCBUF_SMEAR((uint32_t)(size)) + 1)
+
+// *******************************************************
+// CIRCBUF_STORAGE: declare static, word aligned storage named name
+// for a window of size entries, to pass to initCircBufStatic().
+#define CIRCBUF_STORAGE(name, size) \
+	static circBufEntry_t name[CIRCBUF_CAPACITY(size)] __attribute__ ((aligned(4)))
 
 // *******************************************************
 // Buffer structure
 typedef struct {
-	uint32_t size;		// Number of entries in buffer
-	uint32_t windex;	// index for writing, mod(size)
-	uint32_t rindex;	// index for reading, mod(size)
-	uint32_t *data;		// pointer to the data
+	uint32_t size;		// Number of entries in the averaging window
+	uint32_t mask;		// capacity - 1, capacity is a power of two > size
+	volatile uint32_t windex;	// free-running write count, published by writer
+	volatile uint32_t rindex;	// free-running read count, advanced by reader
+	volatile uint32_t sum;	// running sum of the last size entries
+	circBufEntry_t *data;	// pointer to the data
+	bool allocated;		// data came from the heap
 } circBuf_t;
 
 // *******************************************************
 // initCircBuf: Initialise the circBuf instance. Reset both indices to
 // the start of the buffer.  Dynamically allocate and clear the the 
 // memory and return a pointer for the data.  Return NULL if 
-// allocation fails.
-uint32_t *
+// allocation fails or size is 0. The window holds size entries; the
+// storage is the next power of two above size.
+circBufEntry_t *
 initCircBuf (circBuf_t *buffer, uint32_t size);
 
 // *******************************************************
-// writeCircBuf: insert entry at the current windex location,
-// advance windex, modulo (buffer size).
+// initCircBufStatic: Initialise the circBuf instance on caller
+// storage of CIRCBUF_CAPACITY(size) entries, which is cleared. Does
+// not allocate. Returns storage. Asserts that size is not 0.
+circBufEntry_t *
+initCircBufStatic (circBuf_t *buffer, uint32_t size, circBufEntry_t *storage);
+
+// *******************************************************
+// writeCircBuf: insert entry at the current windex location, then
+// publish it by advancing windex. Producer side only. The oldest
+// entries are overwritten when the reader falls behind.
 void
 writeCircBuf (circBuf_t *buffer, uint32_t entry);
 
+// *******************************************************
+// writeCircBufN: insert n entries from src and publish them together
+// with a single advance of windex. Producer side only.
+void
+writeCircBufN (circBuf_t *buffer, const uint32_t *src, uint32_t n);
+
 // *******************************************************
 // readCircBuf: return entry at the current rindex location,
-// advance rindex, modulo (buffer size). The function deos not check
-// if reading has advanced ahead of writing.
+// advance rindex. Consumer side only. The function deos not check
+// if reading has advanced ahead of writing; use circBufCount() first.
 uint32_t
 readCircBuf (circBuf_t *buffer);
 
 // *******************************************************
-// freeCircBuf: Releases the memory allocated to the buffer data,
-// sets pointer to NULL and other fields to 0. The buffer can
-// re initialised by another call to initCircBuf().
+// readCircBufN: copy the n most recently published entries, oldest
+// first, into dest and mark everything up to them as consumed.
+// Consumer side only. The copy is retried if the writer overwrote
+// part of it, so dest always holds n consecutive samples. n is
+// limited to the window size. Returns the number of entries copied,
+// which is less than n only before n entries have been written.
+uint32_t
+readCircBufN (circBuf_t *buffer, uint32_t *dest, uint32_t n);
+
+// *******************************************************
+// circBufCount: return the number of published entries not yet
+// consumed, limited to the storage capacity.
+uint32_t
+circBufCount (circBuf_t *buffer);
+
+// *******************************************************
+// meanCircBuf: return the rounded mean of the last size entries
+// in constant time, using the running sum kept by writeCircBuf().
+// The sum is a single word, so the result is consistent even when
+// writeCircBuf() is called from an ISR.
+uint32_t
+meanCircBuf (circBuf_t *buffer);
+
+// *******************************************************
+// freeCircBuf: Releases the memory allocated to the buffer data, if
+// it came from initCircBuf(), sets pointer to NULL and other fields
+// to 0. The buffer can re initialised by another call to initCircBuf().
 void
 freeCircBuf (circBuf_t *buffer);
 
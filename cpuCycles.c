@@ -0,0 +1,56 @@
+// *******************************************************
+//
+// cpuCycles.c
+//
+// Free-running CPU cycle count from the Cortex-M4 DWT cycle counter
+// (CYCCNT), for timing code.
+//
+// *******************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "cpuCycles.h"
+
+#ifdef HOST_BUILD
+#include <time.h>
+
+//Off-target there is no DWT, so count cycles of a CPU_CLOCK_HZ core from the host monotonic clock
+void
+initCPUCycles(void)
+{
+}
+
+uint32_t
+getCPUCycles(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t)((uint64_t)now.tv_sec * CPU_CLOCK_HZ + (uint64_t)now.tv_nsec * (CPU_CLOCK_HZ / 1000000) / 1000);
+}
+#else
+#include "inc/hw_types.h"
+
+//Core debug and DWT registers (ARMv7-M)
+#define DEMCR               0xE000EDFC
+#define DEMCR_TRCENA        0x01000000
+#define DWT_CTRL            0xE0001000
+#define DWT_CTRL_CYCCNTENA  0x00000001
+#define DWT_CYCCNT          0xE0001004
+
+void
+initCPUCycles(void)
+/* Enable the DWT unit and start the cycle counter
+ */
+{
+    HWREG(DEMCR) |= DEMCR_TRCENA;
+    HWREG(DWT_CYCCNT) = 0;
+    HWREG(DWT_CTRL) |= DWT_CTRL_CYCCNTENA;
+}
+
+uint32_t
+getCPUCycles(void)
+{
+    return HWREG(DWT_CYCCNT);
+}
+#endif /*HOST_BUILD*/
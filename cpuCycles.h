@@ -0,0 +1,24 @@
+// *******************************************************
+//
+// cpuCycles.h
+//
+// Free-running CPU cycle count from the Cortex-M4 DWT cycle counter
+// (CYCCNT), for timing code. Wraps every 2^32 cycles (215 s at
+// 20 MHz), so take differences of unsigned values. Host builds
+// (HOST_BUILD defined) use a stub clock that counts cycles of a
+// CPU_CLOCK_HZ core from the host's monotonic clock.
+//
+// *******************************************************
+
+#ifndef CPUCYCLES_H
+#define CPUCYCLES_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "timingConfig.h"   //CPU_CLOCK_HZ
+
+void initCPUCycles(void);
+
+uint32_t getCPUCycles(void);
+
+#endif /*CPUCYCLES_H*/
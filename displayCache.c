@@ -0,0 +1,62 @@
+// *******************************************************
+//
+// displayCache.c
+//
+// Incremental drawing on the Orbit OLED. Keeps a shadow copy of the
+// characters on the display and only sends the characters of a line
+// that differ from what is already shown.
+//
+// *******************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "OrbitOLED/OrbitOLEDInterface.h"
+#include "displayCache.h"
+
+//Characters currently on the display
+static char shadow[DISPLAY_LINES][DISPLAY_COLUMNS];
+
+void
+initDisplay(void)
+/* Initialise the OLED, which starts blank, and match the shadow copy to it
+ */
+{
+    uint8_t line;
+    uint8_t column;
+
+    OLEDInitialise ();
+    for (line = 0; line < DISPLAY_LINES; line++) {
+        for (column = 0; column < DISPLAY_COLUMNS; column++) {
+            shadow[line][column] = ' ';
+        }
+    }
+}
+
+void
+displayLine(const char *string, uint8_t line)
+/* Compare string with the shadow copy of line and redraw each run of changed characters with one OLEDStringDraw call.
+ * Characters past the end of string are left as they are, as OLEDStringDraw would
+ */
+{
+    char run[DISPLAY_COLUMNS + 1];
+    uint8_t column = 0;
+    uint8_t length;
+
+    while (column < DISPLAY_COLUMNS && string[column] != '\0') {
+        if (string[column] == shadow[line][column]) {
+            column++;
+            continue;
+        }
+        //Collect the run of changed characters starting here
+        length = 0;
+        while (column + length < DISPLAY_COLUMNS && string[column + length] != '\0'
+                && string[column + length] != shadow[line][column + length]) {
+            run[length] = string[column + length];
+            shadow[line][column + length] = run[length];
+            length++;
+        }
+        run[length] = '\0';
+        OLEDStringDraw (run, column, line);
+        column += length;
+    }
+}
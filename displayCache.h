@@ -0,0 +1,26 @@
+// *******************************************************
+//
+// displayCache.h
+//
+// Incremental drawing on the Orbit OLED. Keeps a shadow copy of the
+// characters on the display and only sends the characters of a line
+// that differ from what is already shown.
+//
+// *******************************************************
+
+#ifndef DISPLAYCACHE_H
+#define DISPLAYCACHE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define DISPLAY_COLUMNS 16
+#define DISPLAY_LINES 4
+
+// Initialise the OLED and mark the shadow copy as blank
+void initDisplay(void);
+
+// Draw string from the start of line, sending only the characters that changed
+void displayLine(const char *string, uint8_t line);
+
+#endif /*DISPLAYCACHE_H*/
@@ -0,0 +1,40 @@
+// *******************************************************
+//
+// dmaControl.c
+//
+// Shared uDMA controller set up. Owns the channel control table
+// used by every module that transfers data by uDMA.
+//
+// *******************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "inc/hw_memmap.h"
+#include "inc/hw_types.h"
+#include "driverlib/sysctl.h"
+#include "driverlib/udma.h"
+#include "dmaControl.h"
+
+//Channel control table, must be aligned to 1024 bytes
+#if defined(ccs)
+#pragma DATA_ALIGN(dmaControlTable, 1024)
+static uint8_t dmaControlTable[1024];
+#else
+static uint8_t dmaControlTable[1024] __attribute__ ((aligned(1024)));
+#endif
+
+static bool dmaEnabled = false;
+
+void
+initDMA(void)
+/* Enable the uDMA controller the first time any module needs it
+ */
+{
+    if (dmaEnabled) {
+        return;
+    }
+    SysCtlPeripheralEnable(SYSCTL_PERIPH_UDMA);
+    uDMAEnable();
+    uDMAControlBaseSet(dmaControlTable);
+    dmaEnabled = true;
+}
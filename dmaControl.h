@@ -0,0 +1,20 @@
+// *******************************************************
+//
+// dmaControl.h
+//
+// Shared uDMA controller set up. Owns the channel control table
+// used by every module that transfers data by uDMA.
+//
+// *******************************************************
+
+#ifndef DMACONTROL_H
+#define DMACONTROL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Enable the uDMA controller and point it at the control table.
+// Safe to call from each module that uses a channel.
+void initDMA(void);
+
+#endif /*DMACONTROL_H*/
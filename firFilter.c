@@ -0,0 +1,121 @@
+// *******************************************************
+//
+// firFilter.c
+//
+// FIR filter of ADC samples, two taps per SMLAD on the Cortex-M4.
+//
+// *******************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "firFilter.h"
+
+#ifdef FIR_USE_SMLAD
+#define FIR_PAIR(p) firPair(p)
+
+static uint32_t
+firPair(const int16_t *p)
+/* Two neighbouring int16_t entries as one word, the first in the low half. Copied rather than read through a
+ * uint32_t pointer, which would break strict aliasing. The compiler makes it a single word load
+ */
+{
+    uint32_t pair;
+
+    memcpy(&pair, p, sizeof(pair));
+    return pair;
+}
+#else
+#define FIR_PAIR(p) ((uint32_t)(uint16_t)(p)[0] | ((uint32_t)(uint16_t)(p)[1] << 16))
+#define FIR_SMLAD(x, y, acc) smlad((x), (y), (acc))
+
+static int32_t
+smlad(uint32_t x, uint32_t y, int32_t acc)
+/* Add the products of the low halves and of the high halves of x and y, as signed 16 bit values, to acc
+ */
+{
+    return acc + (int32_t)(int16_t)x * (int16_t)y + (int32_t)(int16_t)(x >> 16) * (int16_t)(y >> 16);
+}
+#endif
+
+void
+initFIR(firFilter_t *fir, const int16_t *coefficients, uint16_t taps, int16_t *storage)
+/* Set up a filter of an even number of taps in storage from FIR_STORAGE(). coefficients[0] applies to the newest
+ * sample. The first sample is taken as the level the input has always had
+ */
+{
+    uint16_t i;
+
+    fir->taps = taps;
+    fir->coeffs[0] = storage;
+    fir->coeffs[1] = storage + taps + 2;
+    fir->history = storage + 2 * (taps + 2);
+    fir->next = 0;
+    fir->primed = false;
+    for (i = 0; i < taps + 2; i++) {
+        fir->coeffs[0][i] = i < taps ? coefficients[taps - 1 - i] : 0;
+        fir->coeffs[1][i] = i > 0 && i <= taps ? coefficients[taps - i] : 0;
+    }
+    for (i = 0; i < 2 * taps + 2; i++) {
+        fir->history[i] = 0;
+    }
+}
+
+static uint16_t
+storeSample(firFilter_t *fir, uint16_t sample)
+/* Add a sample to the history, filling it on the first. Return the index of the oldest of the last taps samples,
+ * which run on to the newest
+ */
+{
+    uint16_t oldest;
+    uint16_t i;
+
+    if (!fir->primed) {
+        for (i = 0; i < 2 * fir->taps; i++) {
+            fir->history[i] = (int16_t)sample;
+        }
+        fir->primed = true;
+    }
+    fir->history[fir->next] = (int16_t)sample;
+    fir->history[fir->next + fir->taps] = (int16_t)sample;
+    oldest = fir->next + 1;
+    fir->next = oldest < fir->taps ? oldest : 0;
+    return oldest;
+}
+
+int32_t
+updateFIR(firFilter_t *fir, uint16_t sample)
+/* Take the next sample and return the filter output in Q15, two taps per multiply-accumulate. When the run of samples
+ * starts on an odd entry it is read from the entry before, against the coefficients with a zero tap in front
+ */
+{
+    uint16_t oldest = storeSample(fir, sample);
+    const int16_t *coeffs = fir->coeffs[oldest & 1];
+    const int16_t *window = &fir->history[oldest & ~1u];
+    uint16_t pairs = fir->taps / 2 + (oldest & 1);
+    int32_t acc = 0;
+
+    while (pairs--) {
+        acc = FIR_SMLAD(FIR_PAIR(window), FIR_PAIR(coeffs), acc);
+        window += 2;
+        coeffs += 2;
+    }
+    return acc;
+}
+
+int32_t
+updateFIRScalar(firFilter_t *fir, uint16_t sample)
+/* Take the next sample and return the filter output in Q15, one tap per multiply-accumulate
+ */
+{
+    uint16_t oldest = storeSample(fir, sample);
+    const int16_t *coeffs = fir->coeffs[0];
+    const int16_t *window = &fir->history[oldest];
+    int32_t acc = 0;
+    uint16_t i;
+
+    for (i = 0; i < fir->taps; i++) {
+        acc += (int32_t)window[i] * coeffs[i];
+    }
+    return acc;
+}
@@ -0,0 +1,62 @@
+// *******************************************************
+//
+// firFilter.h
+//
+// FIR filter of ADC samples, with the multiply-accumulate done two
+// taps at a time by the Cortex-M4 SMLAD instruction on packed 16 bit
+// samples and coefficients. Where SMLAD is not available, as in the
+// host build, a C version of it takes its place and gives the same
+// output bit for bit. updateFIRScalar() runs the same filter one tap
+// per multiply, to compare against.
+//
+// Coefficients are Q15, so the output is the filtered sample in Q15.
+// The taps must be even. Samples of up to 12 bits cannot overflow the
+// accumulator unless the coefficient magnitudes sum to 16.0 or more.
+//
+// Each filter keeps its samples twice over, so the last taps samples
+// are always in one run of memory, and its coefficients reversed twice:
+// once as given, and once behind a zero tap for when that run starts
+// on an odd sample, so every packed load is word aligned. Declare the
+// storage with FIR_STORAGE().
+//
+// *******************************************************
+
+#ifndef FIRFILTER_H
+#define FIRFILTER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//SMLAD from the compiler, on a Cortex-M4 only
+#if defined(__TI_ARM_V7M4__) || defined(__TI_TMS470_V7M4__)
+#define FIR_USE_SMLAD
+#define FIR_SMLAD(x, y, acc) _smlad((x), (y), (acc))
+#elif defined(__ARM_FEATURE_DSP)
+#include <arm_acle.h>
+#define FIR_USE_SMLAD
+#define FIR_SMLAD(x, y, acc) __smlad((x), (y), (acc))
+#endif
+
+// *******************************************************
+// FIR_STORAGE_SIZE: int16_t entries a filter of taps needs, for its two
+// coefficient sets and its samples. FIR_STORAGE: declare them static and
+// word aligned, named name, to pass to initFIR().
+#define FIR_STORAGE_SIZE(taps) (2 * ((taps) + 2) + 2 * (taps) + 2)
+#define FIR_STORAGE(name, taps) \
+    static int16_t name[FIR_STORAGE_SIZE(taps)] __attribute__ ((aligned(4)))
+
+typedef struct {
+    int16_t *coeffs[2];             //Reversed coefficients for a run starting on an even and an odd sample
+    int16_t *history;               //Samples twice over, oldest first, for the runs to be read from
+    uint16_t taps;
+    uint16_t next;                  //Where the next sample goes
+    bool primed;                    //A sample has been taken
+} firFilter_t;
+
+void initFIR(firFilter_t *fir, const int16_t *coefficients, uint16_t taps, int16_t *storage);
+
+int32_t updateFIR(firFilter_t *fir, uint16_t sample);
+
+int32_t updateFIRScalar(firFilter_t *fir, uint16_t sample);
+
+#endif /*FIRFILTER_H*/
@@ -0,0 +1,195 @@
+// *******************************************************
+//
+// heightFilter.c
+//
+// Low latency estimators of the rig height and vertical rate from
+// altitude sensor samples, in fixed point.
+//
+// *******************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "heightFilter.h"
+#include "timingConfig.h"
+
+//The Kalman model and the filter gains are per sample, set for the rates in the comments of heightFilter.h
+TIMING_ASSERT(SAMPLE_RATE_HZ == 200, filterTunedFor200Hz);
+
+//Gains converted to fixed point
+#define FILTER_Q(x) ((int32_t)((x) * (1L << FILTER_Q_BITS) + 0.5))
+#define ALPHA_Q FILTER_Q(FILTER_ALPHA)
+#define BETA_Q FILTER_Q(FILTER_BETA)
+//Hamming windowed sinc low pass, 3 dB down at 10 Hz and 44 dB at 40 Hz for 200 Hz samples, Q15 summing to 1.0
+static const int16_t firCoefficients[FILTER_FIR_TAPS] = {
+    112, 243, 618, 1293, 2217, 3225, 4089, 4587, 4587, 4089, 3225, 2217, 1293, 618, 243, 112
+};
+
+#define GRAVITY_Q FILTER_Q(KALMAN_GRAVITY)
+//Lift per square of ten thousandths of duty, Q15.48
+#define LIFT_Q ((int32_t)(KALMAN_LIFT * 1e-8 * (1LL << (KALMAN_LIFT_BITS + FILTER_Q_BITS)) + 0.5))
+
+static int32_t
+scale(int32_t value, int32_t gain)
+/* Multiply a Q15.16 value by a Q15.16 gain
+ */
+{
+    return (int32_t)(((int64_t)value * gain) >> FILTER_Q_BITS);
+}
+
+static uint16_t
+median(heightFilter_t *filter, uint16_t sample)
+/* Add a sample to the window and return the median of the window. The window is sorted as a copy, which for
+ * FILTER_MEDIAN_N = 5 takes at most 10 comparisons
+ */
+{
+    uint16_t sorted[FILTER_MEDIAN_N];
+    uint16_t value;
+    uint8_t i;
+    uint8_t j;
+
+    filter->window[filter->next] = sample;
+    filter->next = (filter->next + 1) % FILTER_MEDIAN_N;
+    for (i = 0; i < FILTER_MEDIAN_N; i++) {
+        value = filter->window[i];
+        for (j = i; j > 0 && sorted[j - 1] > value; j--) {
+            sorted[j] = sorted[j - 1];
+        }
+        sorted[j] = value;
+    }
+    return sorted[FILTER_MEDIAN_N / 2];
+}
+
+static void
+lowPass(heightFilter_t *filter, int32_t input)
+/* First order low pass of the height, and of its change for the rate
+ */
+{
+    filter->height += (input - filter->height) >> FILTER_IIR_SHIFT;
+    filter->rate += ((filter->height - filter->last) - filter->rate) >> FILTER_IIR_SHIFT;
+    filter->last = filter->height;
+}
+
+static void
+firLowPass(heightFilter_t *filter, uint16_t sample)
+/* FIR low pass of the height, and first order low pass of its change for the rate
+ */
+{
+    filter->height = updateFIR(&filter->fir, sample) << (FILTER_Q_BITS - 15);
+    filter->rate += ((filter->height - filter->last) - filter->rate) >> FILTER_IIR_SHIFT;
+    filter->last = filter->height;
+}
+
+static void
+kalman(heightFilter_t *filter, int32_t input)
+/* Predict the state one sample on from the rotor lift, the rig's weight and the bias, then correct it by the residual
+ */
+{
+    int32_t accel;
+    int32_t residual;
+    int32_t thrustSquared;
+
+    //Thrust follows the commanded duty through the rotor lag, and lift goes as its square
+    filter->thrust += (((int32_t)filter->command << FILTER_Q_BITS) - filter->thrust) >> KALMAN_LAG_SHIFT;
+    thrustSquared = (int32_t)(((int64_t)filter->thrust * filter->thrust) >> (2 * FILTER_Q_BITS));
+    accel = GRAVITY_Q + (filter->bias >> (KALMAN_BIAS_BITS - FILTER_Q_BITS))
+            - (int32_t)(((int64_t)LIFT_Q * thrustSquared) >> KALMAN_LIFT_BITS)
+            - (filter->rate >> KALMAN_DAMPING_SHIFT);
+
+    filter->height += filter->rate + (accel >> 1);
+    filter->rate += accel;
+
+    residual = input - filter->height;
+    filter->height += (int32_t)(((int64_t)residual * KALMAN_K_HEIGHT) >> KALMAN_GAIN_BITS);
+    filter->rate += (int32_t)(((int64_t)residual * KALMAN_K_RATE) >> KALMAN_GAIN_BITS);
+    filter->bias += (int32_t)(((int64_t)residual * KALMAN_K_BIAS)
+                              >> (KALMAN_GAIN_BITS + FILTER_Q_BITS - KALMAN_BIAS_BITS));
+}
+
+void
+initHeightFilter(heightFilter_t *filter, uint8_t type)
+/* Set the estimator type. The first sample is taken as the starting height, with the rig still on the ground, which
+ * carries its weight until the rotor lifts it
+ */
+{
+    filter->type = type;
+    filter->primed = false;
+    filter->height = 0;
+    filter->rate = 0;
+    filter->last = 0;
+    filter->next = 0;
+    filter->bias = -(int32_t)(KALMAN_GRAVITY * (1L << KALMAN_BIAS_BITS) + 0.5);
+    filter->thrust = 0;
+    filter->command = 0;
+    initFIR(&filter->fir, firCoefficients, FILTER_FIR_TAPS, filter->firStorage);
+}
+
+void
+updateHeightFilter(heightFilter_t *filter, uint16_t sample)
+/* Update the estimate with the next ADC sample
+ */
+{
+    int32_t input = (int32_t)sample << FILTER_Q_BITS;
+    int32_t residual;
+    uint8_t i;
+
+    if (!filter->primed) {
+        filter->height = input;
+        filter->last = input;
+        for (i = 0; i < FILTER_MEDIAN_N; i++) {
+            filter->window[i] = sample;
+        }
+        updateFIR(&filter->fir, sample);
+        filter->primed = true;
+        return;
+    }
+
+    switch (filter->type) {
+    case HEIGHT_FILTER_ALPHA_BETA:
+        filter->height += filter->rate;
+        residual = input - filter->height;
+        filter->height += scale(residual, ALPHA_Q);
+        filter->rate += scale(residual, BETA_Q);
+        break;
+    case HEIGHT_FILTER_MEDIAN_IIR:
+        lowPass(filter, (int32_t)median(filter, sample) << FILTER_Q_BITS);
+        break;
+    case HEIGHT_FILTER_KALMAN:
+        kalman(filter, input);
+        break;
+    case HEIGHT_FILTER_FIR:
+        firLowPass(filter, sample);
+        break;
+    default:
+        lowPass(filter, input);
+        break;
+    }
+}
+
+void
+setFilterCommand(heightFilter_t *filter, uint16_t duty)
+/* Give the main rotor duty the controller has commanded, in parts per ten thousand, for the Kalman prediction
+ */
+{
+    filter->command = duty;
+}
+
+uint16_t
+getFilterHeight(const heightFilter_t *filter)
+/* Return the height estimate in whole ADC counts, rounded
+ */
+{
+    int32_t height = filter->height + (1 << (FILTER_Q_BITS - 1));
+
+    if (height < 0) {
+        return 0;
+    }
+    return (uint16_t)(height >> FILTER_Q_BITS);
+}
+
+int32_t
+getFilterRate(const heightFilter_t *filter)
+/* Return the rate estimate in ADC counts per sample, Q15.16
+ */
+{
+    return filter->rate;
+}
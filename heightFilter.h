@@ -0,0 +1,99 @@
+// *******************************************************
+//
+// heightFilter.h
+//
+// Low latency estimators of the rig height and vertical rate from
+// altitude sensor samples, in fixed point. Each is updated with one
+// ADC sample at a time, from the ADC interrupt.
+//
+//  - HEIGHT_FILTER_IIR: first order low pass, a gain of
+//    1 / 2^FILTER_IIR_SHIFT per sample. Rate is the change in the
+//    output, low pass filtered the same way.
+//  - HEIGHT_FILTER_ALPHA_BETA: predicts each sample from the height
+//    and rate, and corrects both by the residual, with gains
+//    FILTER_ALPHA and FILTER_BETA.
+//  - HEIGHT_FILTER_MEDIAN_IIR: median of the last FILTER_MEDIAN_N
+//    samples, to remove single sample spikes, then the first order
+//    low pass.
+//  - HEIGHT_FILTER_KALMAN: steady state Kalman filter of height,
+//    vertical rate and an acceleration bias. The commanded main rotor
+//    duty, set with setFilterCommand(), drives the prediction through
+//    the rotor lag, with lift going as the square of the lagged duty
+//    against the rig's weight. The bias takes up any error in
+//    KALMAN_LIFT and KALMAN_GRAVITY. The gains are fixed for the
+//    noise levels below; host/filterBench -k works them out again
+//    after a change.
+//  - HEIGHT_FILTER_FIR: FILTER_FIR_TAPS tap low pass from firFilter,
+//    two taps per SMLAD on the target. Rate is the change in the
+//    output, low pass filtered as for HEIGHT_FILTER_IIR.
+//
+// Heights are in ADC counts and rates in ADC counts per sample, both
+// Q15.16 in an int32_t.
+//
+// *******************************************************
+
+#ifndef HEIGHTFILTER_H
+#define HEIGHTFILTER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "firFilter.h"
+
+//Estimator types
+#define HEIGHT_FILTER_IIR 0
+#define HEIGHT_FILTER_ALPHA_BETA 1
+#define HEIGHT_FILTER_MEDIAN_IIR 2
+#define HEIGHT_FILTER_KALMAN 3
+#define HEIGHT_FILTER_FIR 4
+#define HEIGHT_FILTERS 5
+
+#define FILTER_Q_BITS 16
+#define FILTER_IIR_SHIFT 3          //Low pass gain 1/8, a group delay of about 7 samples
+#define FILTER_ALPHA 0.25           //Alpha-beta height gain
+#define FILTER_BETA 0.0357          //Alpha-beta rate gain, alpha^2 / (2 - alpha) for critical damping
+#define FILTER_MEDIAN_N 5           //Odd
+#define FILTER_FIR_TAPS 16          //Even; a group delay of 7.5 samples
+
+//Kalman filter model, per ADC sample. ADC counts fall as the rig rises
+#define KALMAN_LIFT 0.582           //Lift at full main duty (counts/sample^2), 23280 counts/s^2
+#define KALMAN_GRAVITY 0.0931       //Weight (counts/sample^2), 3724 counts/s^2, so hovering at 40% duty
+#define KALMAN_LAG_SHIFT 6          //Rotor lag of 2^6 samples, 320 ms
+#define KALMAN_DAMPING_SHIFT 7      //Rate lost to damping, 1/2^7 per sample, 1.56 per second
+#define KALMAN_MEASURE_NOISE 6.2    //Sensor noise standard deviation (counts)
+#define KALMAN_ACCEL_NOISE 0.005    //Unmodelled acceleration standard deviation (counts/sample^2)
+#define KALMAN_BIAS_NOISE 0.002     //Bias random walk standard deviation (counts/sample^2)
+
+//Steady state gains for the noise levels above, Q1.30
+#define KALMAN_GAIN_BITS 30
+#define KALMAN_BIAS_BITS 24         //Fractional bits of the bias state
+#define KALMAN_LIFT_BITS 32         //Fractional bits of the lift per square of ten thousandths of duty
+#define KALMAN_K_HEIGHT 131019471
+#define KALMAN_K_RATE 8521975
+#define KALMAN_K_BIAS 324549
+
+typedef struct {
+    uint8_t type;
+    bool primed;                    //A sample has been taken
+    int32_t height;                 //ADC counts, Q15.16
+    int32_t rate;                   //ADC counts per sample, Q15.16
+    int32_t last;                   //Previous height, for the rate of the low pass types
+    uint16_t window[FILTER_MEDIAN_N];
+    uint8_t next;                   //Oldest sample in window
+    int32_t bias;                   //Kalman acceleration bias, counts per sample^2, Q7.24
+    int32_t thrust;                 //Kalman main duty after the rotor lag, per ten thousand, Q15.16
+    volatile uint16_t command;      //Commanded main duty, per ten thousand
+    firFilter_t fir;
+    int16_t firStorage[FIR_STORAGE_SIZE(FILTER_FIR_TAPS)] __attribute__ ((aligned(4)));
+} heightFilter_t;
+
+void initHeightFilter(heightFilter_t *filter, uint8_t type);
+
+void updateHeightFilter(heightFilter_t *filter, uint16_t sample);
+
+void setFilterCommand(heightFilter_t *filter, uint16_t duty);
+
+uint16_t getFilterHeight(const heightFilter_t *filter);
+
+int32_t getFilterRate(const heightFilter_t *filter);
+
+#endif /*HEIGHTFILTER_H*/
@@ -0,0 +1,343 @@
+// *******************************************************
+//
+// heliHeight.c
+//
+// Supporting module for sampling the altitude sensor of the helicopter
+// rig on AIN9 and averaging the samples in a circular buffer.
+//
+// *******************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "inc/hw_memmap.h"
+#include "inc/hw_types.h"
+#include "inc/hw_adc.h"
+#include "driverlib/adc.h"
+#include "driverlib/sysctl.h"
+#include "driverlib/timer.h"
+#include "driverlib/udma.h"
+#include "driverlib/interrupt.h"
+#include "circBufT.h"
+#include "cicDecimator.h"
+#include "dmaControl.h"
+#include "heightFilter.h"
+#include "heliHeight.h"
+#include "profile.h"
+
+#if defined(HEIGHT_ADC_JITTER) && defined(HEIGHT_ADC_DMA)
+#error "HEIGHT_ADC_JITTER needs an interrupt per sample; build without HEIGHT_ADC_DMA"
+#endif
+#if defined(HEIGHT_ADC_PROCESSOR_TRIGGER) && defined(HEIGHT_ADC_DMA)
+#error "HEIGHT_ADC_DMA is timer triggered; build without HEIGHT_ADC_PROCESSOR_TRIGGER"
+#endif
+#if defined(HEIGHT_OVERSAMPLE) && defined(HEIGHT_ADC_PROCESSOR_TRIGGER)
+#error "HEIGHT_OVERSAMPLE converts faster than SysTick; build without HEIGHT_ADC_PROCESSOR_TRIGGER"
+#endif
+#ifdef HEIGHT_ADC_PROCESSOR_TRIGGER
+TIMING_ASSERT(SYSTICK_RATE_HZ % SAMPLE_RATE_HZ == 0, sysTicksPerSampleWhole);
+#endif
+TIMING_ASSERT(CPU_CLOCK_HZ % HEIGHT_CONVERSION_RATE_HZ == 0, conversionPeriodWhole);
+TIMING_ASSERT((HEIGHT_DECIMATION & (HEIGHT_DECIMATION - 1)) == 0 && HEIGHT_DECIMATION >= 2, decimationPowerOfTwo);
+
+//Circular buffer for altitude ADC
+static circBuf_t    g_inBuffer;         // Buffer of size BUF_SIZE integers (sample values)
+CIRCBUF_STORAGE(g_inStorage, BUF_SIZE);
+
+#ifdef HEIGHT_OVERSAMPLE
+//Brings the conversions down to SAMPLE_RATE_HZ
+static cicDecimator_t decimator;
+#endif
+
+#ifndef HEIGHT_USE_MEAN
+//Height and rate estimator, updated with every sample
+static heightFilter_t heightFilter;
+#else
+//Change in the buffer sum per sample over the last block, which is the rate of the mean times BUF_SIZE
+static volatile int32_t meanSumRate;
+#endif
+
+//Distribution of the periods between conversion complete interrupts
+static sampleJitter_t jitter;
+
+#ifdef HEIGHT_ADC_JITTER
+static uint32_t     lastSampleTime;     //getTimingClock() at the last interrupt
+static bool         jitterPrimed;       //lastSampleTime is set
+
+static void
+recordSampleTime(void)
+/* Timestamp a conversion complete interrupt, and add the period since the last one to the distribution
+ */
+{
+    uint32_t now = getTimingClock();
+    uint32_t period = now - lastSampleTime;
+    int32_t offset;
+    uint32_t bin;
+
+    lastSampleTime = now;
+    if (!jitterPrimed) {
+        jitterPrimed = true;
+        return;
+    }
+    //Shift so bin 0 starts JITTER_BINS / 2 bins and a half below the nominal period
+    offset = (int32_t)(period - HEIGHT_CONVERSION_CYCLES) + (JITTER_BINS / 2) * JITTER_BIN_CYCLES + JITTER_BIN_CYCLES / 2;
+    if (offset < 0) {
+        bin = 0;
+    } else if ((uint32_t)offset >= JITTER_BINS * JITTER_BIN_CYCLES) {
+        bin = JITTER_BINS - 1;
+    } else {
+        bin = (uint32_t)offset / JITTER_BIN_CYCLES;
+    }
+    jitter.bins[bin]++;
+    if (jitter.count == 0 || period < jitter.minPeriod) {
+        jitter.minPeriod = period;
+    }
+    if (period > jitter.maxPeriod) {
+        jitter.maxPeriod = period;
+    }
+    jitter.count++;
+}
+#endif
+
+#ifdef HEIGHT_ADC_DMA
+//Ping-pong halves filled by the uDMA from the sequence 3 FIFO
+static uint32_t     dmaBlock[2][HEIGHT_DMA_BLOCK];
+
+static void
+armDMABlock(uint32_t channelSelect, uint32_t *block)
+/* Queue a ping-pong half to receive the next HEIGHT_DMA_BLOCK samples from the sequence 3 FIFO
+ */
+{
+    uDMAChannelTransferSet(UDMA_CHANNEL_ADC3 | channelSelect, UDMA_MODE_PINGPONG,
+                           (void *)(ADC0_BASE + ADC_O_SSFIFO3), block, HEIGHT_DMA_BLOCK);
+}
+#endif
+
+static void
+storeHeightSamples(const uint32_t *samples, uint32_t count)
+/* Pass samples at SAMPLE_RATE_HZ to the estimator and the mean buffer
+ */
+{
+#ifndef HEIGHT_USE_MEAN
+    uint32_t i;
+
+    countTiming(TIMING_SAMPLE, count);
+    for (i = 0; i < count; i++) {
+        updateHeightFilter(&heightFilter, (uint16_t)samples[i]);
+    }
+    writeCircBufN(&g_inBuffer, samples, count);
+#else
+    uint32_t sum = g_inBuffer.sum;
+
+    countTiming(TIMING_SAMPLE, count);
+    writeCircBufN(&g_inBuffer, samples, count);
+    meanSumRate = (int32_t)(g_inBuffer.sum - sum) / (int32_t)count;
+#endif
+}
+
+void
+heightSampleBlock(const uint32_t *samples, uint32_t count)
+/* Hand a block of altitude samples to the height pipeline. Called from ADCIntHandler with one sample per
+ * conversion, or with a full ping-pong half in the uDMA build. Can also be driven directly off-target.
+ * With HEIGHT_OVERSAMPLE the samples are conversions, decimated here
+ */
+{
+#ifdef HEIGHT_OVERSAMPLE
+    uint32_t i;
+    uint16_t output;
+    uint32_t decimated;
+
+    for (i = 0; i < count; i++) {
+        if (updateCIC(&decimator, (uint16_t)samples[i], &output)) {
+            decimated = output;
+            storeHeightSamples(&decimated, 1);
+        }
+    }
+#else
+    storeHeightSamples(samples, count);
+#endif
+}
+
+void
+ADCIntHandler(void)
+/* ISR for ADC conversion of altitude sensor output voltage, and storage of value into circular buffer at an updated
+ * pointer. Uses circBuffer module
+ */
+{
+    PROFILE_START(PROFILE_ADC_ISR);
+#ifdef HEIGHT_ADC_DMA
+    ADCIntClearEx(ADC0_BASE, ADC_INT_DMA_SS3);
+    //A half in STOP mode has been filled; pass it on and queue it again behind the other half
+    if (uDMAChannelModeGet(UDMA_CHANNEL_ADC3 | UDMA_PRI_SELECT) == UDMA_MODE_STOP) {
+        heightSampleBlock(dmaBlock[0], HEIGHT_DMA_BLOCK);
+        armDMABlock(UDMA_PRI_SELECT, dmaBlock[0]);
+    }
+    if (uDMAChannelModeGet(UDMA_CHANNEL_ADC3 | UDMA_ALT_SELECT) == UDMA_MODE_STOP) {
+        heightSampleBlock(dmaBlock[1], HEIGHT_DMA_BLOCK);
+        armDMABlock(UDMA_ALT_SELECT, dmaBlock[1]);
+    }
+#else
+    uint32_t ulValue;
+#ifdef HEIGHT_ADC_JITTER
+    recordSampleTime();
+#endif
+    // Get the single sample from ADC0.  ADC_BASE is defined in
+    // inc/hw_memmap.h
+    ADCSequenceDataGet(ADC0_BASE, 3, &ulValue);
+    //
+    // Place it in the circular buffer (advancing write index)
+    heightSampleBlock(&ulValue, 1);
+    //
+    // Clean up, clearing the interrupt
+    ADCIntClear(ADC0_BASE, 3);
+#endif
+    PROFILE_END(PROFILE_ADC_ISR);
+}
+
+void
+triggerHeightSample(void)
+/* Start a single conversion from the processor every SYSTICKS_PER_SAMPLE calls. Called from SysTickIntHandler; unless
+ * built with HEIGHT_ADC_PROCESSOR_TRIGGER, Timer0A starts the conversions instead, so there is nothing to do
+ */
+{
+#ifdef HEIGHT_ADC_PROCESSOR_TRIGGER
+    static uint32_t ticks = 0;
+
+    if (++ticks < SYSTICKS_PER_SAMPLE) {
+        return;
+    }
+    ticks = 0;
+    //
+    // Initiate a conversion
+    //
+    ADCProcessorTrigger(ADC0_BASE, 3);
+#endif
+}
+
+void
+initHeightADC (void)
+/* Initialise ADC read from AIN9 for detecting helicopter altitude from sensor. Analogue values from AIN9 is converted to
+ * digital value with resolution 1.24 bits per mV resolution (2^12 bits for voltage range of 3,300 mV)
+ */
+{
+    initCircBufStatic (&g_inBuffer, BUF_SIZE, g_inStorage);
+#ifdef HEIGHT_OVERSAMPLE
+    initCIC (&decimator, HEIGHT_DECIMATION);
+#endif
+#ifndef HEIGHT_USE_MEAN
+    initHeightFilter (&heightFilter, HEIGHT_FILTER);
+#endif
+    //
+    // The ADC0 peripheral must be enabled for configuration and use.
+    SysCtlPeripheralEnable(SYSCTL_PERIPH_ADC0);
+#ifndef HEIGHT_ADC_PROCESSOR_TRIGGER
+    // Timer0A runs at HEIGHT_CONVERSION_RATE_HZ and starts sequence 3 on each timeout
+    SysCtlPeripheralEnable(HEIGHT_TIMER_PERIPH);
+    TimerConfigure(HEIGHT_TIMER_BASE, TIMER_CFG_PERIODIC);
+    TimerLoadSet(HEIGHT_TIMER_BASE, TIMER_A, HEIGHT_CONVERSION_CYCLES - 1);
+    TimerControlTrigger(HEIGHT_TIMER_BASE, TIMER_A, true);
+    ADCSequenceConfigure(ADC0_BASE, 3, ADC_TRIGGER_TIMER, 0);
+#else
+    // Enable sample sequence 3 with a processor signal trigger.  Sequence 3
+    // will do a single sample when the processor sends a signal to start the
+    // conversion.
+    ADCSequenceConfigure(ADC0_BASE, 3, ADC_TRIGGER_PROCESSOR, 0);
+#endif
+#ifdef HEIGHT_OVERSAMPLE
+    // Each trigger gives the mean of HEIGHT_HW_AVERAGE back to back conversions
+    ADCHardwareOversampleConfigure(ADC0_BASE, HEIGHT_HW_AVERAGE);
+#endif
+    // Configure step 0 on sequence 3.  Sample channel 0 (ADC_CTL_CH9) in
+    // single-ended mode (default) and configure the interrupt flag
+    // (ADC_CTL_IE) to be set when the sample is done.  Tell the ADC logic
+    // that this is the last conversion on sequence 3 (ADC_CTL_END).  Sequence
+    // 3 has only one programmable step.  Sequence 1 and 2 have 4 steps, and
+    // sequence 0 has 8 programmable steps.
+    ADCSequenceStepConfigure(ADC0_BASE, 3, 0, ADC_CTL_CH9 | ADC_CTL_IE | ADC_CTL_END);
+    // Since sample sequence 3 is now configured, it must be enabled.
+    ADCSequenceEnable(ADC0_BASE, 3);
+    // Register the interrupt handler
+    ADCIntRegister (ADC0_BASE, 3, ADCIntHandler);
+#ifdef HEIGHT_ADC_DMA
+    // Each sample raises a uDMA request; the ADC interrupt only fires when a ping-pong half is full
+    initDMA();
+    uDMAChannelAssign(UDMA_CH17_ADC0_3);
+    uDMAChannelAttributeDisable(UDMA_CHANNEL_ADC3, UDMA_ATTR_ALL);
+    uDMAChannelControlSet(UDMA_CHANNEL_ADC3 | UDMA_PRI_SELECT,
+                          UDMA_SIZE_32 | UDMA_SRC_INC_NONE | UDMA_DST_INC_32 | UDMA_ARB_1);
+    uDMAChannelControlSet(UDMA_CHANNEL_ADC3 | UDMA_ALT_SELECT,
+                          UDMA_SIZE_32 | UDMA_SRC_INC_NONE | UDMA_DST_INC_32 | UDMA_ARB_1);
+    armDMABlock(UDMA_PRI_SELECT, dmaBlock[0]);
+    armDMABlock(UDMA_ALT_SELECT, dmaBlock[1]);
+    uDMAChannelEnable(UDMA_CHANNEL_ADC3);
+    ADCSequenceDMAEnable(ADC0_BASE, 3);
+    ADCIntEnableEx(ADC0_BASE, ADC_INT_DMA_SS3);
+#else
+    // Enable interrupts for ADC0 sequence 3 (clears any outstanding interrupts)
+    ADCIntEnable(ADC0_BASE, 3);
+#endif
+#ifndef HEIGHT_ADC_PROCESSOR_TRIGGER
+    TimerEnable(HEIGHT_TIMER_BASE, TIMER_A);
+#endif
+}
+
+uint16_t
+getHeightADC(void)
+/* Return the height estimate in ADC counts: the mean of the last BUF_SIZE altitude samples, or the filtered height
+ * unless built with HEIGHT_USE_MEAN
+ */
+{
+#ifndef HEIGHT_USE_MEAN
+    return getFilterHeight (&heightFilter);
+#else
+    return meanCircBuf (&g_inBuffer);
+#endif
+}
+
+int32_t
+getHeightRate(void)
+/* Return the rate of change of the height estimate in ADC counts per second, positive as the rig descends
+ */
+{
+#ifndef HEIGHT_USE_MEAN
+    return (int32_t)(((int64_t)getFilterRate (&heightFilter) * SAMPLE_RATE_HZ) >> FILTER_Q_BITS);
+#else
+    return meanSumRate * SAMPLE_RATE_HZ / BUF_SIZE;
+#endif
+}
+
+void
+setHeightCommand(uint16_t duty)
+/* Give the height estimator the main rotor duty being applied, in parts per ten thousand. Used by HEIGHT_FILTER_KALMAN
+ */
+{
+#ifndef HEIGHT_USE_MEAN
+    setFilterCommand (&heightFilter, duty);
+#endif
+}
+
+bool
+heightBufferFull(void)
+/* Return true once BUF_SIZE samples have been taken. Until then the mean includes the empty entries
+ */
+{
+    return circBufCount (&g_inBuffer) >= BUF_SIZE;
+}
+
+void
+getSampleJitter(sampleJitter_t *result)
+/* Copy out the distribution of periods between conversion complete interrupts since the last call, and start a new
+ * one. All zero unless built with HEIGHT_ADC_JITTER
+ */
+{
+    uint8_t bin;
+
+    IntMasterDisable();
+    *result = jitter;
+    jitter.count = 0;
+    jitter.minPeriod = 0;
+    jitter.maxPeriod = 0;
+    for (bin = 0; bin < JITTER_BINS; bin++) {
+        jitter.bins[bin] = 0;
+    }
+    IntMasterEnable();
+}
@@ -0,0 +1,101 @@
+// *******************************************************
+//
+// heliHeight.h
+//
+// Supporting module for sampling the altitude sensor of the helicopter
+// rig on AIN9 and averaging the samples in a circular buffer.
+//
+// Conversions are started in hardware by Timer0A at SAMPLE_RATE_HZ,
+// so the sample instant does not move with interrupt latency. Three
+// capture paths are available:
+//  - default: ADCIntHandler takes one interrupt per sample from
+//    sequence 3.
+//  - HEIGHT_ADC_DMA: the uDMA moves samples into a ping-pong buffer,
+//    giving one interrupt per HEIGHT_DMA_BLOCK samples.
+//  - HEIGHT_ADC_PROCESSOR_TRIGGER: SysTick calls triggerHeightSample()
+//    to start each conversion in software, as the rig first did.
+// All paths pass samples to heightSampleBlock(). With HEIGHT_OVERSAMPLE
+// the ADC converts HEIGHT_DECIMATION times faster, with hardware
+// averaging, and a CIC decimator brings the stream back down to
+// SAMPLE_RATE_HZ before the estimators see it.
+//
+// *******************************************************
+
+#ifndef HELIHEIGHT_H
+#define HELIHEIGHT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "timingConfig.h"   //SAMPLE_RATE_HZ and BUF_SIZE, the size of the buffer averaging the height sensor
+
+//Build option: the low latency height estimator from heightFilter.h, one of HEIGHT_FILTER_IIR,
+//HEIGHT_FILTER_ALPHA_BETA, HEIGHT_FILTER_MEDIAN_IIR, HEIGHT_FILTER_KALMAN or HEIGHT_FILTER_FIR. Its rate drives the
+//main rotor D term.
+//On the host/filterBench sortie the Kalman filter, given the main duty by setHeightCommand(), gives the cleanest
+//rate, 26.5 counts/s RMS error against 28.8 for the median and low pass filter and 30.9 for the low pass filter
+//alone, with no lag. The median and low pass filter rejects more noise, 11.2 dB against 9.5, but lags by 45 ms
+#ifndef HEIGHT_FILTER
+#define HEIGHT_FILTER HEIGHT_FILTER_KALMAN
+#endif
+
+//Build option: define to use the mean of the last BUF_SIZE samples instead, as the gains were first tuned with.
+//It delays the height by about (BUF_SIZE - 1) / 2 samples, 123 ms, and its rate is as noisy as differencing it
+//#define HEIGHT_USE_MEAN
+
+//Build option: define to convert at HEIGHT_DECIMATION times SAMPLE_RATE_HZ, each conversion the hardware mean of
+//HEIGHT_HW_AVERAGE, and decimate with cicDecimator. Against the mean of BUF_SIZE samples it cuts the noise further
+//with a delay of about 7 ms rather than 123 ms; host/filterBench compares them on an oversampled trace
+//#define HEIGHT_OVERSAMPLE
+#define HEIGHT_DECIMATION 16        //A power of two; 3.2 kHz conversions
+#define HEIGHT_HW_AVERAGE 4         //0 for none, or 2, 4, 8, 16, 32 or 64
+
+#ifdef HEIGHT_OVERSAMPLE
+#define HEIGHT_CONVERSION_RATE_HZ (SAMPLE_RATE_HZ * HEIGHT_DECIMATION)
+#else
+#define HEIGHT_CONVERSION_RATE_HZ SAMPLE_RATE_HZ
+#endif
+#define HEIGHT_CONVERSION_CYCLES (CPU_CLOCK_HZ / HEIGHT_CONVERSION_RATE_HZ)
+
+//Timer starting each conversion at HEIGHT_CONVERSION_RATE_HZ
+#define HEIGHT_TIMER_PERIPH SYSCTL_PERIPH_TIMER0
+#define HEIGHT_TIMER_BASE TIMER0_BASE
+
+//Build option: define to capture samples in blocks by uDMA
+//#define HEIGHT_ADC_DMA
+#define HEIGHT_DMA_BLOCK 8 //Samples per uDMA ping-pong half, one interrupt each
+
+//Build option: define to start conversions from the SysTick interrupt instead of Timer0A
+//#define HEIGHT_ADC_PROCESSOR_TRIGGER
+
+//Build option: define to timestamp every conversion complete interrupt and keep the distribution of the periods
+//between them, read with getSampleJitter(). Needs an interrupt per sample, so not with HEIGHT_ADC_DMA
+//#define HEIGHT_ADC_JITTER
+#define JITTER_BINS 9               //Odd; the middle bin is centred on HEIGHT_CONVERSION_CYCLES
+#define JITTER_BIN_CYCLES (CPU_CLOCK_HZ / 1000000)  //1 us; the end bins also take everything beyond them
+
+typedef struct {
+    uint32_t count;                 //Periods measured
+    uint32_t minPeriod;             //Cycles
+    uint32_t maxPeriod;
+    uint32_t bins[JITTER_BINS];     //Periods in each JITTER_BIN_CYCLES wide bin, shortest first
+} sampleJitter_t;
+
+void initHeightADC(void);
+
+void triggerHeightSample(void);
+
+void ADCIntHandler(void);
+
+void heightSampleBlock(const uint32_t *samples, uint32_t count);
+
+uint16_t getHeightADC(void);
+
+int32_t getHeightRate(void);
+
+void setHeightCommand(uint16_t duty);
+
+bool heightBufferFull(void);
+
+void getSampleJitter(sampleJitter_t *jitter);
+
+#endif /*HELIHEIGHT_H*/
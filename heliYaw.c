@@ -16,80 +16,97 @@
 #include "inc/hw_memmap.h"
 #include "inc/hw_types.h"
 #include "inc/hw_ints.h"
+#include "inc/hw_qei.h"
+#include "inc/tm4c123gh6pm.h"  // Board specific defines (for PD7)
 #include "driverlib/pin_map.h" //Needed for pin configure
 #include "driverlib/debug.h"
 #include "driverlib/gpio.h"
 #include "driverlib/systick.h"
 #include "driverlib/sysctl.h"
 #include "driverlib/interrupt.h"
+#include "driverlib/qei.h"
 #include "utils/ustdlib.h"
 #include "stdlib.h"
 #include "heliYaw.h"
+#include "timingConfig.h"
+#include "profile.h"
 
+#ifndef YAW_USE_QEI
 static uint32_t     currentYawState;
 static int16_t      currentYawCount;        //Incremental/Decremental yaw
 static uint32_t     lastYawState;         //State of last state from quadrature encoder
+#endif
 static uint8_t      homed = false;   //Home signal of encoder
+static volatile uint32_t yawEdgeCount;      //Total encoder edges seen
+static volatile uint32_t yawErrorCount;     //Transitions where both A and B changed, i.e. a missed edge
+#ifndef YAW_USE_QEI
+static volatile int16_t  edgePosition;      //Yaw count without the reset on homing, for the rate
+static volatile uint32_t edgeTime;          //Timestamp of the last edge
+static volatile uint32_t edgeInterval;      //Time between the last two edges, 0 if they were in opposite directions
+static volatile int8_t   edgeDirection;     //Direction of the last edge, +1 or -1
+#endif
+
+#ifndef YAW_USE_QEI
+//Change in yaw count for each transition, indexed by (lastYawState << 2) | currentYawState.
+//State is (B << 1) | A; B leads A for increasing yaw. Transitions with both bits changed are illegal and count as 0
+static const int8_t yawTransition[16] = {
+     0, -1,  1,  0,     //from 0
+     1,  0,  0, -1,     //from 1
+    -1,  0,  0,  1,     //from 2
+     0,  1, -1,  0      //from 3
+};
 
 void
 yawIntHandler(void)
-/* ISR triggered on a rising or falling edge of the quadrature encoder signals A or B. Retaining memory of
- * previous state the current yaw count value is incremented or decremented based on direction of rotation determined from
- * value of changing state
+/* ISR triggered on a rising or falling edge of the quadrature encoder signals A or B. The yaw count is incremented or
+ * decremented by looking up the last and current encoder states in the transition table. A transition where both signals
+ * changed means an edge was missed, so it is counted as an error. Each edge is timestamped for the yaw rate
  */
 {
+    uint32_t now = getTimingClock();
+    int8_t step;
+
+    PROFILE_START(PROFILE_YAW_ISR);
     //Number of slots is 112. Quadrature encoding: 448 max
     currentYawState = GPIOPinRead(GPIO_PORTB_BASE,GPIO_PIN_0|GPIO_PIN_1);
-    switch(currentYawState)
-    {
-    case 0:
-        switch(lastYawState)
-        {
-        case 1:
-            currentYawCount++;
-            break;
-        case 2:
-            currentYawCount--;
-            break;
-        }
-        break;
-    case 1:
-        switch(lastYawState)
-        {
-        case 3:
-            currentYawCount++;
-            break;
-        case 0:
-            currentYawCount--;
-            break;
-        }
-        break;
-    case 2:
-        switch(lastYawState)
-        {
-        case 0:
-            currentYawCount++;
-            break;
-        case 3:
-            currentYawCount--;
-            break;
-        }
-        break;
-    case 3:
-        switch(lastYawState)
-        {
-        case 2:
-            currentYawCount++;
-            break;
-        case 1:
-            currentYawCount--;
-            break;
-        }
-        break;
+    step = yawTransition[(lastYawState << 2) | currentYawState];
+    currentYawCount += step;
+    yawErrorCount += ((lastYawState ^ currentYawState) == 3);
+    if (step != 0) {
+        edgePosition += step;
+        edgeInterval = (step == edgeDirection) ? now - edgeTime : 0;
+        edgeDirection = step;
+        edgeTime = now;
     }
+    yawEdgeCount++;
     lastYawState = currentYawState;
     GPIOIntClear(GPIO_PORTB_BASE, GPIO_INT_PIN_0 | GPIO_PIN_1);
+    PROFILE_END(PROFILE_YAW_ISR);
 }
+#else
+void
+qeiIntHandler(void)
+/* ISR for the QEI index pulse, which is the reference home signal, and for QEI phase errors. The QEI counts every edge
+ * of A and B in hardware, so these are the only yaw interrupts. Count phase errors. On the index pulse zero the position counter to set the reference position to 0, and trigger
+ * homed flag to true
+ */
+{
+    uint32_t status;
+
+    PROFILE_START(PROFILE_YAW_ISR);
+    status = QEIIntStatus(QEI_BASE, true);
+    QEIIntClear(QEI_BASE, status);
+    if (status & QEI_INTERROR) {
+        yawErrorCount++; //Phase error, both signals changed together
+    }
+    if (status & QEI_INTINDEX) {
+        QEIPositionSet(QEI_BASE, 0);
+        homed = true;
+        QEIIntDisable(QEI_BASE, QEI_INTINDEX); //Disable encoder home signal as interrupt
+    }
+    PROFILE_END(PROFILE_YAW_ISR);
+}
+#endif
 
 int8_t
 isHomed(void)
@@ -99,6 +116,7 @@ isHomed(void)
     return homed;
 }
 
+#ifndef YAW_USE_QEI
 void
 homeIntHandler(void)
 /* ISR once reference home signal detected, set currentYawCount to 0 to set the reference position to 0, and trigger homed flag
@@ -111,6 +129,12 @@ homeIntHandler(void)
     GPIOIntClear(GPIO_PORTC_BASE, GPIO_INT_PIN_4);
 }
 
+static uint32_t
+getEdgeCount(void)
+{
+    return yawEdgeCount;
+}
+
 int16_t
 getCurrentYaw(void)
 /* Simple function which returns the updated currentYawCount once called un main function
@@ -142,3 +166,146 @@ initYaw(void)
     GPIOIntRegister(GPIO_PORTC_BASE, homeIntHandler);
     GPIOIntEnable(GPIO_PORTC_BASE, GPIO_INT_PIN_4); //Set encoder home signal as interrupt
 }
+
+int32_t
+getYawRate(void)
+/* Return the yaw rate in encoder counts per second, from the edge timestamps. Must be called once per control period,
+ * as the count-per-window rate runs over the edges since the previous call
+ */
+{
+    static int16_t lastCount;
+    static uint32_t lastTime;
+    uint32_t edges;
+    int16_t count;
+    uint32_t time;
+    uint32_t interval;
+    int8_t direction;
+    uint32_t sinceEdge;
+    int16_t change;
+    int32_t rate = 0;
+
+    //Take a consistent set of edge values, retrying if an edge came in while they were read
+    do {
+        edges = yawEdgeCount;
+        count = edgePosition;
+        time = edgeTime;
+        interval = edgeInterval;
+        direction = edgeDirection;
+    } while (edges != yawEdgeCount);
+    sinceEdge = getTimingClock() - time;
+    change = count - lastCount;
+
+    if (change >= YAW_RATE_MIN_EDGES || change <= -YAW_RATE_MIN_EDGES) {
+        //Fast enough for several edges a period: count per window, timed edge to edge
+        rate = (int32_t)((int64_t)change * CPU_CLOCK_HZ / (time - lastTime));
+    } else if (interval != 0 && sinceEdge < CPU_CLOCK_HZ / 1000 * YAW_RATE_STOP_MS) {
+        //Slow: the last edge interval, or the time since the last edge once the rig has slowed past it
+        if (sinceEdge > interval) {
+            interval = sinceEdge;
+        }
+        rate = direction * (int32_t)(CPU_CLOCK_HZ / interval);
+    }
+    lastCount = count;
+    lastTime = time;
+    return rate;
+}
+#else
+static uint32_t
+getEdgeCount(void)
+/* The QEI does not count edges separately, so accumulate the size of each change in position since the last call
+ */
+{
+    static uint32_t lastPosition;
+    uint32_t position = QEIPositionGet(QEI_BASE);
+    int32_t change = (int32_t)(position - lastPosition);
+
+    lastPosition = position;
+    yawEdgeCount += (change < 0) ? -change : change;
+    return yawEdgeCount;
+}
+
+int16_t
+getCurrentYaw(void)
+/* Return the QEI position counter as the yaw count. The counter wraps at 2^32, so the low 16 bits
+ * give the same signed count as the GPIO decoder
+ */
+{
+    return (int16_t)QEIPositionGet(QEI_BASE);
+}
+
+void
+initYaw(void)
+/* Set up QEI0 to count every edge of encoder signals A and B (448 counts per revolution), with the reference
+ * signal on the index input. The index interrupt homes the yaw count
+ */
+{
+    SysCtlPeripheralEnable (QEI_PERIPH);
+    SysCtlPeripheralEnable (QEI_GPIO_PERIPH);
+    //---Unlock PD7 for PhB0:
+    GPIO_PORTD_LOCK_R = GPIO_LOCK_KEY;
+    GPIO_PORTD_CR_R |= GPIO_PIN_7;
+    GPIO_PORTD_LOCK_R = GPIO_LOCK_M;
+    GPIOPinConfigure (GPIO_PD6_PHA0);
+    GPIOPinConfigure (GPIO_PD7_PHB0);
+    GPIOPinConfigure (GPIO_PD3_IDX0);
+    GPIOPinTypeQEI (QEI_GPIO_BASE, QEI_PINS);
+
+    //B leads A when yaw increases, so swap the phases to count up in the same direction as yawIntHandler
+    QEIConfigure (QEI_BASE, QEI_CONFIG_CAPTURE_A_B | QEI_CONFIG_NO_RESET | QEI_CONFIG_QUADRATURE |
+                  QEI_CONFIG_SWAP, 0xFFFFFFFF);
+    //The reference signal is active low, so invert the index input. QEIConfigure has no flag for this and
+    //overwrites the control register, so set the bit directly after it and before the module is enabled
+    HWREG(QEI_BASE + QEI_O_CTL) |= QEI_CTL_INVI;
+    QEIPositionSet (QEI_BASE, 0);
+    QEIEnable (QEI_BASE);
+
+    QEIIntRegister(QEI_BASE, qeiIntHandler);
+    QEIIntEnable(QEI_BASE, QEI_INTINDEX | QEI_INTERROR); //Set encoder home signal and phase errors as interrupt
+}
+
+int32_t
+getYawRate(void)
+/* Return the yaw rate in encoder counts per second. The QEI gives no edge times, so this is the change in position
+ * over the time since the previous call, which must be once per control period. The period the index pulse
+ * zeroes the position in gives 0
+ */
+{
+    static uint32_t lastPosition;
+    static uint32_t lastTime;
+    static uint8_t lastHomed;
+    uint32_t position = QEIPositionGet(QEI_BASE);
+    uint32_t time = getTimingClock();
+    int32_t change = (int32_t)(position - lastPosition);
+    int32_t rate = 0;
+
+    if (homed == lastHomed) {
+        rate = (int32_t)((int64_t)change * CPU_CLOCK_HZ / (time - lastTime));
+    }
+    lastPosition = position;
+    lastTime = time;
+    lastHomed = homed;
+    return rate;
+}
+#endif
+
+uint32_t
+getYawErrorCount(void)
+/* Return the number of illegal encoder transitions seen since start up. Each one is at least one lost edge
+ */
+{
+    return yawErrorCount;
+}
+
+uint32_t
+getYawEdgeRate(uint16_t pollRateHz)
+/* Return the encoder edge rate in edges per second, from the edges seen since the previous call.
+ * Must be called regularly at pollRateHz
+ */
+{
+    static uint32_t lastEdgeCount;
+    uint32_t edgeCount = getEdgeCount();
+    uint32_t edges = edgeCount - lastEdgeCount;
+
+    lastEdgeCount = edgeCount;
+    return edges * pollRateHz;
+}
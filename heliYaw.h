@@ -26,8 +26,25 @@
 #define REF_PIN GPIO_PIN_4
 #define REF_INT GPIO_INT_PIN_4
 
+//Build option: define to decode yaw with the QEI0 peripheral instead of GPIO edge interrupts.
+//QEI0 needs the encoder wired to PD6 (PhA0) and PD7 (PhB0), and the reference to PD3 (IDX0)
+//#define YAW_USE_QEI
+#define QEI_PERIPH SYSCTL_PERIPH_QEI0
+#define QEI_BASE QEI0_BASE
+#define QEI_GPIO_PERIPH SYSCTL_PERIPH_GPIOD
+#define QEI_GPIO_BASE GPIO_PORTD_BASE
+#define QEI_PINS (GPIO_PIN_3 | GPIO_PIN_6 | GPIO_PIN_7)
+
+//Yaw rate estimation. With at least YAW_RATE_MIN_EDGES edges since the last call, the rate is the edges over the time
+//between the first and last of them. Below that it is one over the last edge interval, or over the time since the last
+//edge if that is longer, and zero once no edge has been seen for YAW_RATE_STOP_MS
+#define YAW_RATE_MIN_EDGES 4
+#define YAW_RATE_STOP_MS 250
+
 void yawIntHandler(void);
 
+void qeiIntHandler(void);
+
 int8_t isHomed(void);
 
 void homeIntHandler(void);
@@ -36,4 +53,10 @@ int16_t getCurrentYaw(void);
 
 void initYaw(void);
 
+uint32_t getYawErrorCount(void);
+
+uint32_t getYawEdgeRate(uint16_t pollRateHz);
+
+int32_t getYawRate(void);
+
 #endif /*HELIYAW_H*/
@@ -0,0 +1,106 @@
+// *******************************************************
+//
+// circBufBench.c
+//
+// Benchmark of meanCircBuf(), which takes the mean of the window from
+// the running sum kept by writeCircBuf(), against the loop it
+// replaced, which read back all size entries with readCircBuf() and
+// summed them every time the height was wanted. For windows of 10,
+// 50 (BUF_SIZE), 200 and 1000 entries filled with pseudo-random 12
+// bit samples, it reports as JSON on stdout:
+//
+//  - mismatches: writes after which the two means differ, which must
+//    be none. The exit status is 1 otherwise
+//  - mean_host_ns and read_loop_host_ns: host wall clock time per
+//    mean, to compare between runs on the same machine. The read loop
+//    grows with the window and the running sum does not. It runs
+//    today's readCircBuf(), whose two memory barriers per entry make
+//    up much of its time on the host
+//
+// The target cost is measured on the rig, under PROFILE_CALC_HEIGHT.
+//
+// Build: make -C host
+// Use:   host/circBufBench
+//
+// *******************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "hostClock.h"
+#include "circBufT.h"
+
+#define BENCH_WRITES 100000         //Samples written, checking both means after each
+#define TIMING_ENTRIES 10000000     //Entries the read loop reads to time a window, so each takes about as long
+#define MAX_SIZE 1000
+
+static const uint32_t benchSizes[] = { 10, 50, 200, 1000 };
+#define NUM_SIZES (sizeof(benchSizes) / sizeof(benchSizes[0]))
+
+CIRCBUF_STORAGE(storage, MAX_SIZE);
+
+static uint32_t
+readLoopMean(circBuf_t *buffer)
+/* The mean as the firmware took it before the running sum: read the last size entries and sum them
+ */
+{
+    uint32_t sum = 0;
+    uint32_t i;
+
+    buffer->rindex = buffer->windex - buffer->size;
+    for (i = 0; i < buffer->size; i++) {
+        sum = sum + readCircBuf(buffer);
+    }
+    return (2 * sum + buffer->size) / 2 / buffer->size;
+}
+
+static double
+timeMean(uint32_t (*mean)(circBuf_t *), circBuf_t *buffer)
+/* Return the mean host nanoseconds per mean of the full buffer
+ */
+{
+    uint32_t means = TIMING_ENTRIES / buffer->size;
+    uint32_t i;
+    uint64_t start;
+    volatile uint32_t sink;
+
+    start = hostNanoseconds();
+    for (i = 0; i < means; i++) {
+        sink = mean(buffer);
+    }
+    (void)sink;
+    return (double)(hostNanoseconds() - start) / means;
+}
+
+int
+main(void)
+{
+    circBuf_t buffer;
+    uint32_t state = 1;
+    uint32_t mismatches;
+    uint32_t i;
+    uint8_t s;
+    bool exact = true;
+
+    printf("{\n  \"windows\": [\n");
+    for (s = 0; s < NUM_SIZES; s++) {
+        initCircBufStatic(&buffer, benchSizes[s], storage);
+        mismatches = 0;
+        for (i = 0; i < BENCH_WRITES; i++) {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            writeCircBuf(&buffer, state & 0xFFF);
+            if (i + 1 >= benchSizes[s] && meanCircBuf(&buffer) != readLoopMean(&buffer)) {
+                mismatches++;
+            }
+        }
+        exact = exact && mismatches == 0;
+        printf("    { \"size\": %u, \"mismatches\": %u, \"mean_host_ns\": %.3f, \"read_loop_host_ns\": %.3f }%s\n",
+               benchSizes[s], mismatches, timeMean(meanCircBuf, &buffer), timeMean(readLoopMean, &buffer),
+               s + 1 < NUM_SIZES ? "," : "");
+    }
+    printf("  ]\n}\n");
+    return exact ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,402 @@
+// *******************************************************
+//
+// filterBench.c
+//
+// Benchmark of the height estimators of heightFilter, and of the
+// mean of the last BUF_SIZE samples they replace, on recorded traces
+// of the altitude sensor. A trace is the CSV written by heliHost -A,
+// rows of time_s,adc,true_adc,main_duty, where true_adc is the noise
+// free sensor output and main_duty the main rotor duty the Kalman
+// filter is given. For each trace and estimator it reports as JSON on
+// stdout:
+//
+//  - latency_ms: the delay of the estimate behind the true height,
+//    taken as the lag that best lines the two up
+//  - noise_rejection_db: the RMS noise of the raw samples over the
+//    RMS error of the estimate once lined up, in dB
+//  - error_rms_counts: the RMS error of the estimate as the controller
+//    sees it, delay and noise together
+//  - rate_error_rms: the RMS error of the rate estimate, in ADC counts
+//    per second. The rate of the mean is its change per sample, as
+//    heliHeight gives it
+//  - host_ns_per_sample: host wall clock time to filter the whole
+//    trace, per sample, so compare only between runs on the same
+//    machine. The target cost is measured on the rig, under
+//    PROFILE_CALC_HEIGHT
+//
+// A trace recorded from a HEIGHT_OVERSAMPLE build holds every
+// conversion, HEIGHT_HW_AVERAGE * HEIGHT_DECIMATION per sample. The
+// estimators above are then given one conversion per sample, as the
+// firmware without oversampling takes them, and a further "cic"
+// estimator is given the whole stream: averaged as the ADC hardware
+// does, then through cicDecimator. Its rate is the change per output,
+// and its time is per output, not counting the hardware average.
+//
+// With -k it instead prints the steady state Kalman gains for the
+// model and noise levels in heightFilter.h, to paste back into it.
+//
+// Build: make -C host
+// Use:   host/heliHost -p -q -t 70 -A adc.csv -e 0.5:fly -e 35:up -e 45:down -e 55:land
+//        host/filterBench adc.csv
+//        host/filterBench -k
+//        make -C host FIRMWARE_FLAGS=-DHEIGHT_OVERSAMPLE filterbench
+//
+// *******************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "hostClock.h"
+#include "circBufT.h"
+#include "cicDecimator.h"
+#include "heliHeight.h"
+#include "heightFilter.h"
+
+#define MAX_LAG 100                 //Longest latency looked for, in samples
+#define TIMING_PASSES 20            //Times each trace is filtered to time an estimator
+#define MEAN_ESTIMATOR HEIGHT_FILTERS   //Index of the mean after the filters
+#define CIC_ESTIMATOR (HEIGHT_FILTERS + 1)  //Index of the decimator, for oversampled traces only
+#define RICCATI_ITERATIONS 100000   //Enough for the gains to settle to double precision
+#define HW_AVERAGE (HEIGHT_HW_AVERAGE > 1 ? HEIGHT_HW_AVERAGE : 1)
+#define OVERSAMPLE (HW_AVERAGE * HEIGHT_DECIMATION)    //Conversions per sample in an oversampled trace
+
+static const char *estimatorNames[HEIGHT_FILTERS + 2] = {
+    "iir", "alpha_beta", "median_iir", "kalman", "fir", "mean", "cic"
+};
+
+//The trace being measured
+static uint16_t     *adc;
+static uint16_t     *duty;
+static double       *truth;
+static double       *estimate;
+static double       *rate;
+static uint32_t     samples;
+static uint16_t     *conversions;   //Hardware averaged conversions, HEIGHT_DECIMATION per sample, or NULL
+
+CIRCBUF_STORAGE(meanStorage, BUF_SIZE);
+
+static bool
+readTrace(const char *name)
+/* Read a trace into adc, truth and duty. Return false if it cannot be read. An oversampled trace is cut down to one
+ * conversion per sample, and its hardware averaged conversions kept in conversions
+ */
+{
+    FILE *file = fopen(name, "r");
+    uint32_t size = 0;
+    char line[128];
+    double time;
+    double start = 0.0;
+    long value;
+    double exact;
+    double percent;
+    int fields;
+    uint32_t sum;
+    uint32_t i;
+    uint32_t n;
+
+    if (file == NULL) {
+        perror(name);
+        return false;
+    }
+    samples = 0;
+    while (fgets(line, sizeof(line), file) != NULL) {
+        fields = sscanf(line, "%lf,%ld,%lf,%lf", &time, &value, &exact, &percent);
+        if (fields < 3) {
+            continue;               //Header
+        }
+        if (fields < 4) {
+            percent = 0.0;          //Trace from before main_duty was recorded
+        }
+        if (samples == size) {
+            size = size ? size * 2 : 4096;
+            adc = realloc(adc, size * sizeof(*adc));
+            duty = realloc(duty, size * sizeof(*duty));
+            truth = realloc(truth, size * sizeof(*truth));
+            estimate = realloc(estimate, size * sizeof(*estimate));
+            rate = realloc(rate, size * sizeof(*rate));
+            if (adc == NULL || duty == NULL || truth == NULL || estimate == NULL || rate == NULL) {
+                perror("filterBench");
+                exit(EXIT_FAILURE);
+            }
+        }
+        if (samples == 0) {
+            start = time;
+        }
+        adc[samples] = (uint16_t)value;
+        duty[samples] = (uint16_t)lround(percent * 100.0);   //Per ten thousand, as the firmware commands it
+        truth[samples] = exact;
+        samples++;
+    }
+    fclose(file);
+
+    free(conversions);
+    conversions = NULL;
+    if (samples < 2 || lround((samples - 1) / ((time - start) * SAMPLE_RATE_HZ)) != OVERSAMPLE || OVERSAMPLE == 1) {
+        return true;
+    }
+    //Oversampled. The last conversion of each sample stands for the firmware without oversampling
+    conversions = malloc(samples / HW_AVERAGE * sizeof(*conversions));
+    if (conversions == NULL) {
+        perror("filterBench");
+        exit(EXIT_FAILURE);
+    }
+    for (i = 0; i < samples / HW_AVERAGE; i++) {
+        sum = 0;
+        for (n = 0; n < HW_AVERAGE; n++) {
+            sum += adc[i * HW_AVERAGE + n];
+        }
+        conversions[i] = sum / HW_AVERAGE;
+    }
+    samples /= OVERSAMPLE;
+    for (i = 0; i < samples; i++) {
+        adc[i] = adc[i * OVERSAMPLE + OVERSAMPLE - 1];
+        duty[i] = duty[i * OVERSAMPLE + OVERSAMPLE - 1];
+        truth[i] = truth[i * OVERSAMPLE + OVERSAMPLE - 1];
+    }
+    return true;
+}
+
+static void
+runEstimator(uint8_t estimator)
+/* Run an estimator over the trace, filling estimate and rate
+ */
+{
+    heightFilter_t filter;
+    circBuf_t mean;
+    cicDecimator_t cic;
+    uint32_t i;
+    uint32_t n;
+    uint32_t sum;
+    uint16_t output = 0;
+
+    if (estimator == CIC_ESTIMATOR) {
+        initCIC(&cic, HEIGHT_DECIMATION);
+        for (i = 0; i < samples; i++) {
+            for (n = 0; n < HEIGHT_DECIMATION; n++) {
+                updateCIC(&cic, conversions[i * HEIGHT_DECIMATION + n], &output);
+            }
+            rate[i] = i > 0 ? (output - estimate[i - 1]) * SAMPLE_RATE_HZ : 0.0;
+            estimate[i] = output;
+        }
+        return;
+    }
+    if (estimator == MEAN_ESTIMATOR) {
+        initCircBufStatic(&mean, BUF_SIZE, meanStorage);
+        for (i = 0; i < samples; i++) {
+            sum = mean.sum;
+            writeCircBuf(&mean, adc[i]);
+            //The firmware waits for a full window, so start from the first sample as the filters do
+            estimate[i] = i + 1 < BUF_SIZE ? adc[0] : meanCircBuf(&mean);
+            rate[i] = i + 1 < BUF_SIZE ? 0.0 : (double)(int32_t)(mean.sum - sum) * SAMPLE_RATE_HZ / BUF_SIZE;
+        }
+        return;
+    }
+    initHeightFilter(&filter, estimator);
+    for (i = 0; i < samples; i++) {
+        setFilterCommand(&filter, duty[i]);
+        updateHeightFilter(&filter, adc[i]);
+        estimate[i] = getFilterHeight(&filter);
+        rate[i] = (double)getFilterRate(&filter) * SAMPLE_RATE_HZ / (1 << FILTER_Q_BITS);
+    }
+}
+
+static double
+timeEstimator(uint8_t estimator)
+/* Return the mean host nanoseconds to take in one sample and read the estimate, timed over the whole trace
+ */
+{
+    heightFilter_t filter;
+    circBuf_t mean;
+    cicDecimator_t cic;
+    uint32_t pass;
+    uint32_t i;
+    uint64_t start;
+    uint64_t elapsed = 0;
+    uint16_t output;
+    volatile uint32_t sink;
+
+    for (pass = 0; pass < TIMING_PASSES; pass++) {
+        if (estimator == CIC_ESTIMATOR) {
+            initCIC(&cic, HEIGHT_DECIMATION);
+            start = hostNanoseconds();
+            for (i = 0; i < samples * HEIGHT_DECIMATION; i++) {
+                if (updateCIC(&cic, conversions[i], &output)) {
+                    sink = output;
+                }
+            }
+        } else if (estimator == MEAN_ESTIMATOR) {
+            initCircBufStatic(&mean, BUF_SIZE, meanStorage);
+            start = hostNanoseconds();
+            for (i = 0; i < samples; i++) {
+                writeCircBuf(&mean, adc[i]);
+                sink = meanCircBuf(&mean);
+            }
+        } else {
+            initHeightFilter(&filter, estimator);
+            start = hostNanoseconds();
+            for (i = 0; i < samples; i++) {
+                setFilterCommand(&filter, duty[i]);
+                updateHeightFilter(&filter, adc[i]);
+                sink = getFilterHeight(&filter);
+            }
+        }
+        elapsed += hostNanoseconds() - start;
+    }
+    (void)sink;
+    return samples > 0 ? (double)elapsed / ((uint64_t)samples * TIMING_PASSES) : 0.0;
+}
+
+static double
+rmsError(const double *value, const double *reference, uint32_t lag)
+/* Return the RMS of value[i] - reference[i - lag], over the samples from MAX_LAG on so every lag uses the same ones
+ */
+{
+    double sum = 0.0;
+    uint32_t i;
+
+    for (i = MAX_LAG; i < samples; i++) {
+        sum += (value[i] - reference[i - lag]) * (value[i] - reference[i - lag]);
+    }
+    return sqrt(sum / (samples - MAX_LAG));
+}
+
+static void
+measureTrace(const char *name, bool last)
+{
+    double *raw = malloc(samples * sizeof(double));
+    double *trueRate = malloc(samples * sizeof(double));
+    double rawNoise;
+    double error;
+    double lagError;
+    uint32_t lag;
+    uint32_t bestLag;
+    uint32_t i;
+    uint8_t estimator;
+    uint8_t lastEstimator = conversions != NULL ? CIC_ESTIMATOR : MEAN_ESTIMATOR;
+
+    if (raw == NULL || trueRate == NULL) {
+        perror("filterBench");
+        exit(EXIT_FAILURE);
+    }
+    for (i = 0; i < samples; i++) {
+        raw[i] = adc[i];
+        //Central difference of the noise free output, in counts per second
+        trueRate[i] = i > 0 && i + 1 < samples ? (truth[i + 1] - truth[i - 1]) * SAMPLE_RATE_HZ / 2.0 : 0.0;
+    }
+    rawNoise = rmsError(raw, truth, 0);
+
+    printf("    { \"file\": \"%s\", \"samples\": %u, \"raw_noise_rms_counts\": %.3f,\n"
+           "      \"estimators\": [\n", name, samples, rawNoise);
+    for (estimator = 0; estimator <= lastEstimator; estimator++) {
+        runEstimator(estimator);
+        bestLag = 0;
+        lagError = rmsError(estimate, truth, 0);
+        for (lag = 1; lag <= MAX_LAG; lag++) {
+            error = rmsError(estimate, truth, lag);
+            if (error < lagError) {
+                lagError = error;
+                bestLag = lag;
+            }
+        }
+        printf("        { \"name\": \"%s\", \"latency_ms\": %.1f, \"noise_rejection_db\": %.2f,"
+               " \"error_rms_counts\": %.3f, \"rate_error_rms\": %.2f, \"host_ns_per_sample\": %.3f }%s\n",
+               estimatorNames[estimator], bestLag * 1000.0 / SAMPLE_RATE_HZ,
+               lagError > 0.0 ? 20.0 * log10(rawNoise / lagError) : 0.0, rmsError(estimate, truth, 0),
+               rmsError(rate, trueRate, 0), timeEstimator(estimator), estimator < lastEstimator ? "," : "");
+    }
+    printf("      ] }%s\n", last ? "" : ",");
+    free(raw);
+    free(trueRate);
+}
+
+static void
+printKalmanGains(void)
+/* Iterate the discrete Riccati equation for the heightFilter model, state (height, rate, bias) per sample, to the
+ * steady state and print its gains as heightFilter.h defines them
+ */
+{
+    const double damping = 1.0 / (1L << KALMAN_DAMPING_SHIFT);
+    const double f[3][3] = { { 1.0, 1.0 - damping / 2.0, 0.5 }, { 0.0, 1.0 - damping, 1.0 }, { 0.0, 0.0, 1.0 } };
+    const double g[3] = { 0.5, 1.0, 0.0 };  //How an acceleration disturbance enters the state
+    double p[3][3] = { { 0.0 } };
+    double fp[3][3];
+    double k[3];
+    double q[3][3];
+    double r = KALMAN_MEASURE_NOISE * KALMAN_MEASURE_NOISE;
+    double s;
+    uint32_t n;
+    uint8_t i;
+    uint8_t j;
+    uint8_t m;
+
+    for (i = 0; i < 3; i++) {
+        for (j = 0; j < 3; j++) {
+            q[i][j] = KALMAN_ACCEL_NOISE * KALMAN_ACCEL_NOISE * g[i] * g[j];
+        }
+    }
+    q[2][2] += KALMAN_BIAS_NOISE * KALMAN_BIAS_NOISE;
+    for (n = 0; n < RICCATI_ITERATIONS; n++) {
+        //Predict, P = F P F' + Q
+        for (i = 0; i < 3; i++) {
+            for (j = 0; j < 3; j++) {
+                fp[i][j] = 0.0;
+                for (m = 0; m < 3; m++) {
+                    fp[i][j] += f[i][m] * p[m][j];
+                }
+            }
+        }
+        for (i = 0; i < 3; i++) {
+            for (j = 0; j < 3; j++) {
+                p[i][j] = q[i][j];
+                for (m = 0; m < 3; m++) {
+                    p[i][j] += fp[i][m] * f[j][m];
+                }
+            }
+        }
+        //Correct by a measurement of height, P = (I - K H) P
+        s = p[0][0] + r;
+        for (i = 0; i < 3; i++) {
+            k[i] = p[i][0] / s;
+        }
+        for (i = 0; i < 3; i++) {
+            for (j = 0; j < 3; j++) {
+                fp[i][j] = p[i][j] - k[i] * p[0][j];
+            }
+        }
+        memcpy(p, fp, sizeof(p));
+    }
+    printf("#define KALMAN_K_HEIGHT %ld\n", lround(k[0] * (1L << KALMAN_GAIN_BITS)));
+    printf("#define KALMAN_K_RATE %ld\n", lround(k[1] * (1L << KALMAN_GAIN_BITS)));
+    printf("#define KALMAN_K_BIAS %ld\n", lround(k[2] * (1L << KALMAN_GAIN_BITS)));
+}
+
+int
+main(int argc, char *argv[])
+{
+    int i;
+
+    if (argc == 2 && strcmp(argv[1], "-k") == 0) {
+        printKalmanGains();
+        return EXIT_SUCCESS;
+    }
+    if (argc < 2) {
+        fprintf(stderr, "Use: %s trace.csv...\n       %s -k\n", argv[0], argv[0]);
+        return EXIT_FAILURE;
+    }
+    printf("{\n  \"traces\": [\n");
+    for (i = 1; i < argc; i++) {
+        if (!readTrace(argv[i])) {
+            return EXIT_FAILURE;
+        }
+        if (samples <= MAX_LAG) {
+            fprintf(stderr, "filterBench: %s is shorter than %u samples\n", argv[i], MAX_LAG + 1);
+            return EXIT_FAILURE;
+        }
+        measureTrace(argv[i], i + 1 == argc);
+    }
+    printf("  ]\n}\n");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,154 @@
+// *******************************************************
+//
+// firBench.c
+//
+// Correctness check of the firFilter kernels. For low pass filters of
+// 16, 32 and 64 taps it runs updateFIR(), two taps per SMLAD, and
+// updateFIRScalar(), one tap per multiply, over the same pseudo-random
+// 12 bit samples, and reports as JSON on stdout:
+//
+//  - mismatches: outputs where either differs from the convolution
+//    worked out directly, which must be none. The exit status is 1
+//    otherwise
+//  - packed_host_ns_per_output and scalar_host_ns_per_output: host
+//    wall clock time, to compare between runs on the same machine
+//
+// The host build has no SMLAD and runs the C version of it, reported
+// as "kernel": "portable", so its times are the cost of that emulation
+// on the host and are no evidence of the gain on the target. Measure
+// that on the rig, under PROFILE_ADC_ISR with HEIGHT_FILTER_FIR.
+//
+// Build: make -C host
+// Use:   host/firBench
+//
+// *******************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "hostClock.h"
+#include "firFilter.h"
+
+#define BENCH_SAMPLES 100000
+#define TIMING_PASSES 20
+#define MAX_TAPS 64
+#define CUTOFF 0.05                 //Of the sample rate
+
+static const uint16_t benchTaps[] = { 16, 32, 64 };
+#define NUM_FILTERS (sizeof(benchTaps) / sizeof(benchTaps[0]))
+
+FIR_STORAGE(packedStorage, MAX_TAPS);
+FIR_STORAGE(scalarStorage, MAX_TAPS);
+
+static uint16_t     input[BENCH_SAMPLES];
+
+static void
+designLowPass(int16_t *coefficients, uint16_t taps)
+/* Hamming windowed sinc low pass at CUTOFF, in Q15 and adjusted at the centre to sum to exactly 1.0
+ */
+{
+    double ideal[MAX_TAPS];
+    double sum = 0.0;
+    double m;
+    int32_t total = 0;
+    uint16_t n;
+
+    for (n = 0; n < taps; n++) {
+        m = n - (taps - 1) / 2.0;
+        ideal[n] = sin(2.0 * M_PI * CUTOFF * m) / (M_PI * m) * (0.54 - 0.46 * cos(2.0 * M_PI * n / (taps - 1)));
+        sum += ideal[n];
+    }
+    for (n = 0; n < taps; n++) {
+        coefficients[n] = (int16_t)lround(ideal[n] / sum * 32768.0);
+        total += coefficients[n];
+    }
+    coefficients[taps / 2] += 32768 - total;
+}
+
+static int32_t
+convolve(const int16_t *coefficients, uint16_t taps, uint32_t n)
+/* Return output n of the filter worked out directly, taking the input before the first sample to be the first sample
+ */
+{
+    int32_t acc = 0;
+    uint16_t k;
+
+    for (k = 0; k < taps; k++) {
+        acc += (int32_t)coefficients[k] * input[n >= k ? n - k : 0];
+    }
+    return acc;
+}
+
+static double
+timeKernel(int32_t (*update)(firFilter_t *, uint16_t), const int16_t *coefficients, uint16_t taps,
+           int16_t *storage)
+/* Return the mean host nanoseconds per output of a kernel
+ */
+{
+    firFilter_t fir;
+    uint32_t pass;
+    uint32_t i;
+    uint64_t start;
+    uint64_t elapsed = 0;
+    volatile int32_t sink;
+
+    for (pass = 0; pass < TIMING_PASSES; pass++) {
+        initFIR(&fir, coefficients, taps, storage);
+        start = hostNanoseconds();
+        for (i = 0; i < BENCH_SAMPLES; i++) {
+            sink = update(&fir, input[i]);
+        }
+        elapsed += hostNanoseconds() - start;
+    }
+    (void)sink;
+    return (double)elapsed / ((uint64_t)BENCH_SAMPLES * TIMING_PASSES);
+}
+
+int
+main(void)
+{
+    int16_t coefficients[MAX_TAPS];
+    firFilter_t packed;
+    firFilter_t scalar;
+    uint32_t state = 1;
+    uint32_t mismatches;
+    uint32_t i;
+    int32_t expected;
+    uint8_t f;
+    bool exact = true;
+
+    for (i = 0; i < BENCH_SAMPLES; i++) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        input[i] = state & 0xFFF;
+    }
+
+#ifdef FIR_USE_SMLAD
+    printf("{\n  \"kernel\": \"smlad\",\n  \"filters\": [\n");
+#else
+    printf("{\n  \"kernel\": \"portable\",\n  \"filters\": [\n");
+#endif
+    for (f = 0; f < NUM_FILTERS; f++) {
+        designLowPass(coefficients, benchTaps[f]);
+        initFIR(&packed, coefficients, benchTaps[f], packedStorage);
+        initFIR(&scalar, coefficients, benchTaps[f], scalarStorage);
+        mismatches = 0;
+        for (i = 0; i < BENCH_SAMPLES; i++) {
+            expected = convolve(coefficients, benchTaps[f], i);
+            if (updateFIR(&packed, input[i]) != expected || updateFIRScalar(&scalar, input[i]) != expected) {
+                mismatches++;
+            }
+        }
+        exact = exact && mismatches == 0;
+        printf("    { \"taps\": %u, \"mismatches\": %u, \"packed_host_ns_per_output\": %.3f,"
+               " \"scalar_host_ns_per_output\": %.3f }%s\n", benchTaps[f], mismatches,
+               timeKernel(updateFIR, coefficients, benchTaps[f], packedStorage),
+               timeKernel(updateFIRScalar, coefficients, benchTaps[f], scalarStorage),
+               f + 1 < NUM_FILTERS ? "," : "");
+    }
+    printf("  ]\n}\n");
+    return exact ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,604 @@
+// *******************************************************
+//
+// gainTune.c
+//
+// Tunes the main and tail rotor controller gains by flying the
+// unchanged firmware against the simulated rig of heliPlant, and
+// writes the best gains found as a replacement PIDGains.h.
+//
+// Each candidate set of gains flies the same scripted sortie: take
+// off after homing, climb, yaw right, descend and yaw back. Each
+// step is scored from its rise time, overshoot, settling time and
+// actuator effort (stepMetrics.h), and the candidate's cost is the
+// weighted sum over the sortie. Sensor noise uses the same seed for
+// every candidate, so costs compare like with like.
+//
+// The search is a grid of GRID_POINTS per gain, spaced evenly in log
+// scale across a ratio of the current gains either way (about
+// GRID_ZERO_CENTRE for a gain that is 0), then
+// Nelder-Mead in log gain from the best grid points. Each
+// Nelder-Mead iteration tries the reflected, expanded and both
+// contracted points of every simplex together, so a batch has enough
+// flights to keep all the workers busy.
+//
+// The firmware runs once per process, so every flight is a forked
+// child of a parent that has not started it. Up to one child per core
+// runs at a time, each taking the next candidate as it starts and
+// returning its result in shared memory. Workers share nothing else,
+// so throughput scales with the cores.
+//
+// Build: make -C host
+// Use:   host/gainTune -o PIDGains.h
+//        host/gainTune -j 32 -g 7 -r 8 -k 8 -n 60
+//
+// *******************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include "cpuCycles.h"
+#include "PIDController.h"
+#include "hostSim.h"
+#include "hostEvents.h"
+#include "heliPlant.h"
+#include "stepMetrics.h"
+
+#define NUM_GAINS 6                 //KP, KI, KD, KP_t, KI_t, KD_t
+#define GRID_POINTS 5               //Default grid points per gain
+#define GRID_RATIO 4.0              //Default grid span, either way from the current gains
+#define GRID_ZERO_CENTRE 0.01       //Grid centre for a gain that is 0 in PIDGains.h, such as an untuned D term
+#define NM_STARTS 4                 //Default number of Nelder-Mead simplices
+#define NM_ITERATIONS 40            //Default Nelder-Mead iterations
+#define NM_STEP 0.7                 //Initial simplex size in log gain, about a factor of 2
+#define NM_TOLERANCE 1e-3           //A simplex has converged when its costs are this close
+#define BAD_COST 1e9                //Cost of a flight that failed
+
+#define TUNE_SAMPLE_HZ 1000         //Rate the rig is recorded at
+#define TUNE_RUN_S 34.0             //Length of the sortie
+#define TUNE_START_YAW 5.0          //Degrees from home at the start, so homing is quick
+#define HOME_YAW (0.5 * 360.0 / ENCODER_COUNTS) //The rig is homed once the encoder reaches the home count
+#define TUNE_SAMPLES 34000          //TUNE_RUN_S * TUNE_SAMPLE_HZ
+
+//Cost weights
+#define WEIGHT_RISE 1.0             //Per second
+#define WEIGHT_SETTLE 1.0           //Per second
+#define WEIGHT_OVERSHOOT 0.1        //Per percent of the step
+#define WEIGHT_EFFORT 0.001         //Per duty percent per second
+
+static const char *gainNames[NUM_GAINS] = { "KP", "KI", "KD", "KP_t", "KI_t", "KD_t" };
+static const double currentGains[NUM_GAINS] = { KP, KI, KD, KP_t, KI_t, KD_t };
+
+//The scripted sortie
+static const struct {
+    double time;
+    const char *action;
+} script[] = {
+    { 0.5, "fly" },
+    { 8.0, "up" }, { 8.3, "up" }, { 8.6, "up" },
+    { 16.0, "right" }, { 16.3, "right" },
+    { 22.0, "down" }, { 22.3, "down" },
+    { 28.0, "left" }, { 28.3, "left" },
+};
+
+//The steps scored, each from its start until the next. A start of 0 is when the rig is homed
+typedef struct {
+    const char *name;
+    double start;                   //Seconds
+    bool yaw;                       //Yaw in degrees, otherwise height in percent
+    double target;
+    double minBand;                 //Narrowest settling band
+} manoeuvre_t;
+
+static const manoeuvre_t manoeuvres[] = {
+    { "take off",   0.0,  false,  10.0,  1.0 },
+    { "climb",      8.0,  false,  40.0,  1.0 },
+    { "yaw right",  16.0, true,   30.0,  2.0 },
+    { "descend",    22.0, false,  20.0,  1.0 },
+    { "yaw left",   28.0, true,   0.0,   2.0 },
+};
+
+#define NUM_MANOEUVRES (sizeof(manoeuvres) / sizeof(manoeuvres[0]))
+
+typedef struct {
+    double gain[NUM_GAINS];
+    double cost;
+    stepMetrics_t steps[NUM_MANOEUVRES];
+} candidate_t;
+
+typedef struct {
+    candidate_t vertex[NUM_GAINS + 1];
+    bool converged;
+} simplex_t;
+
+//Search settings
+static uint32_t     jobs;
+static uint32_t     gridPoints = GRID_POINTS;
+static double       gridRatio = GRID_RATIO;
+static uint32_t     starts = NM_STARTS;
+static uint32_t     iterations = NM_ITERATIONS;
+static uint32_t     seed = 1;
+
+static candidate_t  best;
+static uint32_t     flights;
+
+//Rig recording in a flight, in the child process
+static float        height[TUNE_SAMPLES];
+static float        yaw[TUNE_SAMPLES];
+static float        mainDuty[TUNE_SAMPLES];
+static float        tailDuty[TUNE_SAMPLES];
+static uint32_t     samples;
+static int32_t      homedSample = -1;
+
+int heliMain(void);
+
+//*****************************************************************************
+// One flight, run in a child process
+//*****************************************************************************
+static void
+recordHook(void)
+/* Record the rig, and the sample at which it reached home
+ */
+{
+    const plantState_t *rig = getPlantState();
+
+    if (samples == TUNE_SAMPLES) {
+        return;
+    }
+    height[samples] = rig->height * 100.0;
+    yaw[samples] = rig->yaw;
+    mainDuty[samples] = rig->mainDuty * 100.0;
+    tailDuty[samples] = rig->tailDuty * 100.0;
+    if (homedSample < 0 && rig->yaw < HOME_YAW) {
+        homedSample = samples;
+    }
+    samples++;
+}
+
+static void
+fly(candidate_t *candidate)
+/* Fly the sortie with the candidate's gains, and score it
+ */
+{
+    plantParams_t params = plantDefaults;
+    uint32_t i;
+    uint32_t first;
+    uint32_t last;
+    const manoeuvre_t *step;
+    stepMetrics_t *metrics;
+
+    params.startYaw = TUNE_START_YAW;
+    params.seed = seed;
+    setPIDGains(candidate->gain[0], candidate->gain[1], candidate->gain[2], candidate->gain[3], candidate->gain[4],
+                candidate->gain[5]);
+    hostSetUARTOutput(NULL);
+    initPlant(&params);
+    for (i = 0; i < sizeof(script) / sizeof(script[0]); i++) {
+        hostAddEvent(script[i].time, script[i].action);
+    }
+    hostStartEvents();
+    hostAddHook(recordHook, CPU_CLOCK_HZ / TUNE_SAMPLE_HZ);
+
+    candidate->cost = BAD_COST;
+    if (hostRun(heliMain, (uint64_t)(TUNE_RUN_S * CPU_CLOCK_HZ)) != 0 || homedSample < 0) {
+        return;
+    }
+    candidate->cost = 0.0;
+    for (i = 0; i < NUM_MANOEUVRES; i++) {
+        step = &manoeuvres[i];
+        metrics = &candidate->steps[i];
+        first = step->start > 0.0 ? (uint32_t)(step->start * TUNE_SAMPLE_HZ) : (uint32_t)homedSample;
+        last = i + 1 < NUM_MANOEUVRES ? (uint32_t)(manoeuvres[i + 1].start * TUNE_SAMPLE_HZ) : samples;
+        if (first >= last) {
+            candidate->cost = BAD_COST;
+            return;
+        }
+        if (step->yaw) {
+            measureStep(&yaw[first], &tailDuty[first], last - first, TUNE_SAMPLE_HZ, step->target, step->minBand,
+                        metrics);
+        } else {
+            measureStep(&height[first], &mainDuty[first], last - first, TUNE_SAMPLE_HZ, step->target,
+                        step->minBand, metrics);
+        }
+        candidate->cost += WEIGHT_RISE * metrics->riseTime + WEIGHT_SETTLE * metrics->settlingTime
+                           + WEIGHT_OVERSHOOT * metrics->overshoot + WEIGHT_EFFORT * metrics->effort;
+    }
+}
+
+//*****************************************************************************
+// Worker pool
+//*****************************************************************************
+static void
+flyAll(candidate_t *list, uint32_t count)
+/* Fly every candidate, up to jobs at a time, each in a forked child that writes its result to shared memory
+ */
+{
+    candidate_t *shared;
+    pid_t *slotPid;
+    uint32_t *slotIndex;
+    uint32_t next = 0;
+    uint32_t running = 0;
+    uint32_t slot;
+    int status;
+    pid_t pid;
+
+    if (count == 0) {
+        return;
+    }
+    shared = mmap(NULL, count * sizeof(candidate_t), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    slotPid = calloc(jobs, sizeof(pid_t));
+    slotIndex = calloc(jobs, sizeof(uint32_t));
+    if (shared == MAP_FAILED || slotPid == NULL || slotIndex == NULL) {
+        perror("gainTune");
+        exit(EXIT_FAILURE);
+    }
+    memcpy(shared, list, count * sizeof(candidate_t));
+    fflush(NULL);
+
+    while (next < count || running > 0) {
+        //Start a flight in every free slot
+        for (slot = 0; slot < jobs && next < count; slot++) {
+            if (slotPid[slot] != 0) {
+                continue;
+            }
+            pid = fork();
+            if (pid < 0) {
+                perror("gainTune: fork");
+                exit(EXIT_FAILURE);
+            }
+            if (pid == 0) {
+                fly(&shared[next]);
+                _exit(EXIT_SUCCESS);
+            }
+            slotPid[slot] = pid;
+            slotIndex[slot] = next++;
+            running++;
+        }
+
+        //Wait for one to finish
+        pid = wait(&status);
+        if (pid < 0) {
+            perror("gainTune: wait");
+            exit(EXIT_FAILURE);
+        }
+        for (slot = 0; slot < jobs && slotPid[slot] != pid; slot++) {
+        }
+        if (slot == jobs) {
+            continue;
+        }
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS) {
+            shared[slotIndex[slot]].cost = BAD_COST;
+        }
+        slotPid[slot] = 0;
+        running--;
+    }
+
+    memcpy(list, shared, count * sizeof(candidate_t));
+    munmap(shared, count * sizeof(candidate_t));
+    free(slotPid);
+    free(slotIndex);
+
+    for (next = 0; next < count; next++) {
+        if (list[next].cost < best.cost) {
+            best = list[next];
+        }
+    }
+    flights += count;
+}
+
+//*****************************************************************************
+// Search
+//*****************************************************************************
+static int
+compareCost(const void *a, const void *b)
+{
+    double costA = ((const candidate_t *)a)->cost;
+    double costB = ((const candidate_t *)b)->cost;
+
+    return (costA > costB) - (costA < costB);
+}
+
+static candidate_t *
+gridSearch(uint32_t *count)
+/* Fly every point of the grid, and return them sorted by cost
+ */
+{
+    candidate_t *grid;
+    uint32_t total = 1;
+    uint32_t i;
+    uint32_t g;
+    uint32_t digit;
+    double exponent;
+
+    for (g = 0; g < NUM_GAINS; g++) {
+        total *= gridPoints;
+    }
+    grid = calloc(total, sizeof(candidate_t));
+    if (grid == NULL) {
+        perror("gainTune");
+        exit(EXIT_FAILURE);
+    }
+    for (i = 0; i < total; i++) {
+        digit = i;
+        for (g = 0; g < NUM_GAINS; g++) {
+            exponent = gridPoints > 1 ? 2.0 * (digit % gridPoints) / (gridPoints - 1) - 1.0 : 0.0;
+            grid[i].gain[g] = (currentGains[g] > 0.0 ? currentGains[g] : GRID_ZERO_CENTRE) * pow(gridRatio, exponent);
+            digit /= gridPoints;
+        }
+    }
+    flyAll(grid, total);
+    qsort(grid, total, sizeof(candidate_t), compareCost);
+    *count = total;
+    return grid;
+}
+
+static void
+movePoint(const double *centroid, const double *worst, double factor, candidate_t *point)
+/* Set point at centroid + factor * (centroid - worst), in log gain
+ */
+{
+    uint32_t g;
+
+    for (g = 0; g < NUM_GAINS; g++) {
+        point->gain[g] = exp(log(centroid[g]) + factor * (log(centroid[g]) - log(worst[g])));
+    }
+}
+
+static void
+nelderMead(const candidate_t *startPoints, uint32_t count)
+/* Refine from each start point with its own simplex, trying the candidate points of all the simplices together
+ */
+{
+    simplex_t *simplices = calloc(count, sizeof(simplex_t));
+    candidate_t *trial = calloc(count * 4, sizeof(candidate_t));
+    candidate_t *shrink = calloc(count * NUM_GAINS, sizeof(candidate_t));
+    bool *shrinking = calloc(count, sizeof(bool));
+    double centroid[NUM_GAINS];
+    uint32_t s;
+    uint32_t v;
+    uint32_t g;
+    uint32_t n;
+    uint32_t iteration;
+    simplex_t *simplex;
+    candidate_t *worst;
+    candidate_t *r;
+
+    if (simplices == NULL || trial == NULL || shrink == NULL || shrinking == NULL) {
+        perror("gainTune");
+        exit(EXIT_FAILURE);
+    }
+
+    //Start each simplex a factor of about 2 along each gain from its start point. The new vertices fill the
+    //shrink list exactly
+    n = 0;
+    for (s = 0; s < count; s++) {
+        simplices[s].vertex[0] = startPoints[s];
+        for (v = 1; v <= NUM_GAINS; v++) {
+            shrink[n] = startPoints[s];
+            shrink[n++].gain[v - 1] *= exp(NM_STEP);
+        }
+    }
+    flyAll(shrink, n);
+    n = 0;
+    for (s = 0; s < count; s++) {
+        for (v = 1; v <= NUM_GAINS; v++) {
+            simplices[s].vertex[v] = shrink[n++];
+        }
+    }
+
+    for (iteration = 0; iteration < iterations; iteration++) {
+        //Reflected, expanded, outside and inside contracted points of every simplex still going
+        n = 0;
+        for (s = 0; s < count; s++) {
+            simplex = &simplices[s];
+            qsort(simplex->vertex, NUM_GAINS + 1, sizeof(candidate_t), compareCost);
+            simplex->converged = simplex->vertex[NUM_GAINS].cost - simplex->vertex[0].cost < NM_TOLERANCE;
+            if (simplex->converged) {
+                continue;
+            }
+            for (g = 0; g < NUM_GAINS; g++) {
+                centroid[g] = 0.0;
+                for (v = 0; v < NUM_GAINS; v++) {
+                    centroid[g] += log(simplex->vertex[v].gain[g]);
+                }
+                centroid[g] = exp(centroid[g] / NUM_GAINS);
+            }
+            worst = &simplex->vertex[NUM_GAINS];
+            movePoint(centroid, worst->gain, 1.0, &trial[n++]);
+            movePoint(centroid, worst->gain, 2.0, &trial[n++]);
+            movePoint(centroid, worst->gain, 0.5, &trial[n++]);
+            movePoint(centroid, worst->gain, -0.5, &trial[n++]);
+        }
+        if (n == 0) {
+            break;
+        }
+        flyAll(trial, n);
+
+        //Take the usual Nelder-Mead step for each
+        n = 0;
+        for (s = 0; s < count; s++) {
+            simplex = &simplices[s];
+            shrinking[s] = false;
+            if (simplex->converged) {
+                continue;
+            }
+            worst = &simplex->vertex[NUM_GAINS];
+            r = &trial[n];
+            if (r[0].cost < simplex->vertex[0].cost) {
+                *worst = r[1].cost < r[0].cost ? r[1] : r[0];
+            } else if (r[0].cost < simplex->vertex[NUM_GAINS - 1].cost) {
+                *worst = r[0];
+            } else if (r[0].cost < worst->cost && r[2].cost <= r[0].cost) {
+                *worst = r[2];
+            } else if (r[0].cost >= worst->cost && r[3].cost < worst->cost) {
+                *worst = r[3];
+            } else {
+                shrinking[s] = true;
+            }
+            n += 4;
+        }
+
+        //Shrink the simplices that found nothing better towards their best vertex
+        n = 0;
+        for (s = 0; s < count; s++) {
+            if (!shrinking[s]) {
+                continue;
+            }
+            for (v = 1; v <= NUM_GAINS; v++) {
+                for (g = 0; g < NUM_GAINS; g++) {
+                    shrink[n].gain[g] = sqrt(simplices[s].vertex[0].gain[g] * simplices[s].vertex[v].gain[g]);
+                }
+                n++;
+            }
+        }
+        flyAll(shrink, n);
+        n = 0;
+        for (s = 0; s < count; s++) {
+            if (!shrinking[s]) {
+                continue;
+            }
+            for (v = 1; v <= NUM_GAINS; v++) {
+                simplices[s].vertex[v] = shrink[n++];
+            }
+        }
+
+        fprintf(stderr, "gainTune: iteration %u, best cost %.4f\n", iteration + 1, best.cost);
+    }
+
+    free(simplices);
+    free(trial);
+    free(shrink);
+    free(shrinking);
+}
+
+//*****************************************************************************
+// Output
+//*****************************************************************************
+static void
+writeHeader(FILE *file, const candidate_t *current)
+/* Write the best gains as a replacement PIDGains.h, with the scores they were chosen on
+ */
+{
+    uint32_t i;
+    const stepMetrics_t *metrics;
+
+    fprintf(file, "/**********************************************************\n"
+                  " *\n"
+                  " * PIDGains.h\n"
+                  " *\n"
+                  " * Gains for the main and tail rotor controllers in PIDController.\n"
+                  " * Written by host/gainTune after %u simulated sorties, seed %u.\n"
+                  " * Cost %.4f, against %.4f for the gains it started from.\n"
+                  " *\n"
+                  " * Step          rise (s)  overshoot (%%)  settling (s)  effort (%%/s)\n",
+            flights, seed, best.cost, current->cost);
+    for (i = 0; i < NUM_MANOEUVRES; i++) {
+        metrics = &best.steps[i];
+        fprintf(file, " * %-12s  %8.3f  %13.1f  %12.3f  %12.1f\n", manoeuvres[i].name, metrics->riseTime,
+                metrics->overshoot, metrics->settlingTime, metrics->effort);
+    }
+    fprintf(file, " **********************************************************/\n"
+                  "#ifndef PIDGAINS_H\n"
+                  "#define PIDGAINS_H\n"
+                  "\n"
+                  "//Main Controller Gains\n");
+    for (i = 0; i < NUM_GAINS; i++) {
+        if (i == 3) {
+            fprintf(file, "\n//Tail Controller Gains\n");
+        }
+        fprintf(file, "#define %s %.4g\n", gainNames[i], best.gain[i]);
+    }
+    fprintf(file, "\n#endif /*PIDGAINS_H*/\n");
+}
+
+int
+main(int argc, char *argv[])
+{
+    const char *outName = NULL;
+    FILE *out = stdout;
+    candidate_t current;
+    candidate_t *grid;
+    uint32_t gridCount;
+    struct timespec began;
+    struct timespec ended;
+    double seconds;
+    int option;
+
+    jobs = sysconf(_SC_NPROCESSORS_ONLN) > 0 ? sysconf(_SC_NPROCESSORS_ONLN) : 1;
+    while ((option = getopt(argc, argv, "j:g:r:k:n:s:o:")) != -1) {
+        switch (option) {
+        case 'j':
+            jobs = atoi(optarg);
+            break;
+        case 'g':
+            gridPoints = atoi(optarg);
+            break;
+        case 'r':
+            gridRatio = atof(optarg);
+            break;
+        case 'k':
+            starts = atoi(optarg);
+            break;
+        case 'n':
+            iterations = atoi(optarg);
+            break;
+        case 's':
+            seed = strtoul(optarg, NULL, 0);
+            break;
+        case 'o':
+            outName = optarg;
+            break;
+        default:
+            fprintf(stderr, "Use: %s [-j jobs] [-g gridPoints] [-r gridRatio] [-k starts] [-n iterations] [-s seed]"
+                    " [-o PIDGains.h]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (jobs < 1 || gridPoints < 1 || gridPoints > 9 || gridRatio <= 1.0 || starts < 1) {
+        fprintf(stderr, "gainTune: need at least one job and start, 1 to 9 grid points and a ratio over 1\n");
+        return EXIT_FAILURE;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &began);
+
+    //The gains in PIDGains.h, to compare against
+    best.cost = BAD_COST * 2;
+    memcpy(current.gain, currentGains, sizeof(currentGains));
+    flyAll(&current, 1);
+    fprintf(stderr, "gainTune: current gains cost %.4f\n", current.cost);
+
+    grid = gridSearch(&gridCount);
+    fprintf(stderr, "gainTune: %u grid points, best cost %.4f\n", gridCount, best.cost);
+    if (starts > gridCount) {
+        starts = gridCount;
+    }
+    nelderMead(grid, starts);
+    free(grid);
+
+    clock_gettime(CLOCK_MONOTONIC, &ended);
+    seconds = (ended.tv_sec - began.tv_sec) + (ended.tv_nsec - began.tv_nsec) * 1e-9;
+    fprintf(stderr, "gainTune: %u sorties in %.1f s on %u jobs, %.1f per second\n", flights, seconds, jobs,
+            flights / seconds);
+
+    if (best.cost >= BAD_COST) {
+        fprintf(stderr, "gainTune: no candidate flew the sortie\n");
+        return EXIT_FAILURE;
+    }
+    if (outName != NULL) {
+        out = fopen(outName, "w");
+        if (out == NULL) {
+            perror(outName);
+            return EXIT_FAILURE;
+        }
+    }
+    writeHeader(out, &current);
+    if (out != stdout) {
+        fclose(out);
+    }
+    return EXIT_SUCCESS;
+}
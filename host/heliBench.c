@@ -0,0 +1,382 @@
+// *******************************************************
+//
+// heliBench.c
+//
+// Step response benchmark. Flies the unchanged firmware against the
+// simulated rig of heliPlant through a fixed sortie, and reports the
+// tracking and timing measures as JSON on stdout:
+//
+//  - the homing spin of flySortie, from switching to fly until the
+//    rig reaches the reference
+//  - take off to 10%, then the 10% height steps and 15 degree yaw
+//    steps that pollButtons makes, each with the measures of
+//    stepMetrics.h
+//  - the heliLanding sequence, until the motors are turned off
+//  - the host nanoseconds per control step of the two controllers,
+//    from replaying the recorded flight through them after it ends,
+//    the fastest of passes over at least REPLAY_MIN_S. This is host
+//    time, so compare it only between runs on the same machine
+//
+// With -b the results are compared with an earlier run, and the exit
+// status is 1 if any measure is worse by more than the tolerance plus
+// a floor for that measure. Measures that are null in the earlier
+// run are not compared. make -C host bench compares the results with
+// host/benchBaseline.json, a run of the gains hand tuned on the rig
+// with the controller time left null, or with another run given as
+// BENCH_BASELINE=bench.json
+//
+// Build: make -C host
+// Use:   host/heliBench > bench.json
+//        host/heliBench -b bench.json -t 10
+//
+// *******************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include "timingConfig.h"
+#include "hostClock.h"
+#include "PIDController.h"
+#include "hostSim.h"
+#include "hostEvents.h"
+#include "heliPlant.h"
+#include "stepMetrics.h"
+
+#ifndef BENCH_FLAGS
+#define BENCH_FLAGS ""              //Firmware build options, recorded with the results
+#endif
+
+#define BENCH_SAMPLE_HZ 1000        //Rate the rig is recorded at
+#define BENCH_RUN_S 140.0           //Length of the sortie
+#define BENCH_SAMPLES 140000        //BENCH_RUN_S * BENCH_SAMPLE_HZ
+#define BENCH_TOLERANCE 5.0         //Default percentage a measure may worsen by before it fails a comparison
+#define TIME_TOLERANCE 25.0         //Percentage for the controller time, which varies with load on the host
+#define TIME_FLOOR_NS 5.0           //Change in controller time always allowed, nanoseconds per step
+#define REPLAY_MIN_S 0.2            //Least host time the flight is replayed through the controllers to time them
+#define FLY_TIME 0.5
+#define LAND_TIME 110.0
+#define LANDED_ADC 2482             //Altitude sensor on the ground, plantDefaults.landedVolts
+
+//The scripted sortie
+static const struct {
+    double time;
+    const char *action;
+} script[] = {
+    { FLY_TIME, "fly" },
+    { 60.0, "up" },
+    { 75.0, "down" },
+    { 90.0, "right" },
+    { 100.0, "left" },
+    { LAND_TIME, "land" },
+};
+
+//The steps measured, each from its start until the next. A start of 0 is when the rig is homed
+typedef struct {
+    const char *name;
+    double start;                   //Seconds
+    bool yaw;                       //Yaw in degrees, otherwise height in percent
+    double target;
+    double minBand;                 //Narrowest settling band
+} manoeuvre_t;
+
+static const manoeuvre_t manoeuvres[] = {
+    { "takeoff",    0.0,  false,  10.0,  1.0 },
+    { "height_up",  60.0, false,  20.0,  1.0 },
+    { "height_down", 75.0, false, 10.0,  1.0 },
+    { "yaw_right",  90.0, true,   15.0,  2.0 },
+    { "yaw_left",   100.0, true,  0.0,   2.0 },
+};
+
+#define NUM_MANOEUVRES (sizeof(manoeuvres) / sizeof(manoeuvres[0]))
+
+//Measures compared with a baseline. All are better lower; floor is the change always allowed, in their units
+typedef struct {
+    const char *key;
+    double floor;
+} measure_t;
+
+static const measure_t stepMeasures[] = {
+    { "rise_time_s", 0.02 },
+    { "overshoot_pct", 1.0 },
+    { "settling_time_s", 0.02 },
+    { "steady_state_error", 0.2 },
+    { "effort_pct_per_s", 5.0 },
+};
+
+#define NUM_STEP_MEASURES (sizeof(stepMeasures) / sizeof(stepMeasures[0]))
+
+//Rig recording
+static float        height[BENCH_SAMPLES];
+static float        yaw[BENCH_SAMPLES];
+static float        mainDuty[BENCH_SAMPLES];
+static float        tailDuty[BENCH_SAMPLES];
+static uint32_t     samples;
+static int32_t      homedSample = -1;
+static int32_t      landedSample = -1;
+
+//Results, indexed as stepMeasures
+static double       stepResults[NUM_MANOEUVRES][NUM_STEP_MEASURES];
+static double       homingTime;
+static double       landingTime;
+static double       controlTime;
+
+//Comparison with a baseline
+static char         *baseline;
+static double       tolerance = BENCH_TOLERANCE;
+static uint32_t     regressions;
+
+int heliMain(void);
+
+static void
+recordHook(void)
+/* Record the rig, the sample at which it reached home and the sample at which the motors stopped after landing
+ */
+{
+    const plantState_t *rig = getPlantState();
+
+    if (samples == BENCH_SAMPLES) {
+        return;
+    }
+    height[samples] = rig->height * 100.0;
+    yaw[samples] = rig->yaw;
+    mainDuty[samples] = rig->mainDuty * 100.0;
+    tailDuty[samples] = rig->tailDuty * 100.0;
+    if (homedSample < 0 && samples > 0 && hostSeconds() > FLY_TIME
+        && (fabs(rig->yaw) < 0.5 * 360.0 / ENCODER_COUNTS || (rig->yaw < 0.0) != (yaw[samples - 1] < 0.0))) {
+        homedSample = samples;
+    }
+    if (landedSample < 0 && hostSeconds() > LAND_TIME && rig->mainDuty == 0.0 && rig->tailDuty == 0.0) {
+        landedSample = samples;
+    }
+    samples++;
+}
+
+static void
+measureSteps(void)
+{
+    uint32_t i;
+    uint32_t first;
+    uint32_t last;
+    const manoeuvre_t *step;
+    stepMetrics_t metrics;
+
+    for (i = 0; i < NUM_MANOEUVRES; i++) {
+        step = &manoeuvres[i];
+        first = step->start > 0.0 ? (uint32_t)(step->start * BENCH_SAMPLE_HZ) : (uint32_t)homedSample;
+        last = (uint32_t)((i + 1 < NUM_MANOEUVRES ? manoeuvres[i + 1].start : LAND_TIME) * BENCH_SAMPLE_HZ);
+        if (step->yaw) {
+            measureStep(&yaw[first], &tailDuty[first], last - first, BENCH_SAMPLE_HZ, step->target, step->minBand,
+                        &metrics);
+        } else {
+            measureStep(&height[first], &mainDuty[first], last - first, BENCH_SAMPLE_HZ, step->target,
+                        step->minBand, &metrics);
+        }
+        stepResults[i][0] = metrics.riseTime;
+        stepResults[i][1] = metrics.overshoot;
+        stepResults[i][2] = metrics.settlingTime;
+        stepResults[i][3] = metrics.steadyError;
+        stepResults[i][4] = metrics.effort;
+    }
+}
+
+static double
+timeControllers(void)
+/* Replay the recorded flight through both controllers at the control rate, pass after pass for at least
+ * REPLAY_MIN_S, and return the host nanoseconds for one control period in the fastest pass, the one least
+ * disturbed by the rest of the host
+ */
+{
+    uint32_t stride = BENCH_SAMPLE_HZ / CONTROL_RATE_HZ;
+    uint32_t i;
+    uint32_t steps;
+    uint64_t begin = hostNanoseconds();
+    uint64_t start;
+    double fastest = -1.0;
+    double passTime;
+    uint16_t targetADC = LANDED_ADC - (10 * RANGE_ADC) / 100;
+    uint16_t heightADC;
+    uint16_t lastADC;
+    int16_t lastYaw;
+
+    do {
+        lastADC = LANDED_ADC;
+        lastYaw = 0;
+        steps = 0;
+        start = hostNanoseconds();
+        for (i = 0; i < samples; i += stride) {
+            heightADC = LANDED_ADC - (uint16_t)(height[i] * RANGE_ADC / 100);
+            PIDMainControl(heightADC, targetADC, LANDED_ADC, ((int32_t)heightADC - lastADC) * CONTROL_RATE_HZ);
+            lastADC = heightADC;
+            PIDTailControl(0, (int16_t)yaw[i], ((int16_t)yaw[i] - lastYaw) * CONTROL_RATE_HZ);
+            lastYaw = (int16_t)yaw[i];
+            steps++;
+        }
+        passTime = (double)(hostNanoseconds() - start) / steps;
+        if (fastest < 0.0 || passTime < fastest) {
+            fastest = passTime;
+        }
+    } while (hostNanoseconds() - begin < (uint64_t)(REPLAY_MIN_S * 1e9));
+    return fastest;
+}
+
+//*****************************************************************************
+// Comparison with a baseline
+//*****************************************************************************
+static bool
+baselineValue(const char *name, const char *key, double *value)
+/* Find a measure in the baseline, in the manoeuvre called name or at the top level if name is NULL. Return false
+ * if it is missing or null
+ */
+{
+    char pattern[64];
+    const char *from = baseline;
+    const char *end = NULL;
+    const char *found;
+
+    if (name != NULL) {
+        snprintf(pattern, sizeof(pattern), "\"name\": \"%s\"", name);
+        from = strstr(baseline, pattern);
+        if (from == NULL) {
+            return false;
+        }
+        end = strchr(from, '}');
+    }
+    snprintf(pattern, sizeof(pattern), "\"%s\":", key);
+    found = strstr(from, pattern);
+    if (found == NULL || (end != NULL && found > end)) {
+        return false;
+    }
+    found += strlen(pattern);
+    if (strncmp(found, " null", 5) == 0) {
+        return false;
+    }
+    *value = strtod(found, NULL);
+    return true;
+}
+
+static void
+compare(const char *name, const char *key, double value, double percent, double floor)
+/* Count and report a measure that is worse than the baseline by more than percent plus floor. A measure that
+ * could not be taken (negative) is worse than any baseline that has one
+ */
+{
+    double old;
+
+    if (baseline == NULL || !baselineValue(name, key, &old)) {
+        return;
+    }
+    if (value < 0.0 || value > old * (1.0 + percent / 100.0) + floor) {
+        fprintf(stderr, "heliBench: %s%s%s regressed from %.4g to %.4g\n", name ? name : "", name ? " " : "", key,
+                old, value);
+        regressions++;
+    }
+}
+
+static char *
+readFile(const char *name)
+{
+    FILE *file = fopen(name, "r");
+    char *text;
+    long size;
+
+    if (file == NULL) {
+        perror(name);
+        exit(EXIT_FAILURE);
+    }
+    fseek(file, 0, SEEK_END);
+    size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    text = malloc(size + 1);
+    if (text == NULL || fread(text, 1, size, file) != (size_t)size) {
+        perror(name);
+        exit(EXIT_FAILURE);
+    }
+    text[size] = '\0';
+    fclose(file);
+    return text;
+}
+
+//*****************************************************************************
+// Output
+//*****************************************************************************
+static void
+printMeasure(const char *key, double value, bool last)
+/* Print a measure, as null if it could not be taken
+ */
+{
+    if (value < 0.0) {
+        printf("  \"%s\": null%s\n", key, last ? "" : ",");
+    } else {
+        printf("  \"%s\": %.4f%s\n", key, value, last ? "" : ",");
+    }
+}
+
+int
+main(int argc, char *argv[])
+{
+    plantParams_t params = plantDefaults;
+    uint32_t i;
+    uint32_t m;
+    int option;
+
+    while ((option = getopt(argc, argv, "s:b:t:")) != -1) {
+        switch (option) {
+        case 's':
+            params.seed = strtoul(optarg, NULL, 0);
+            break;
+        case 'b':
+            baseline = readFile(optarg);
+            break;
+        case 't':
+            tolerance = atof(optarg);
+            break;
+        default:
+            fprintf(stderr, "Use: %s [-s seed] [-b baseline.json [-t tolerancePercent]]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    hostSetUARTOutput(NULL);
+    initPlant(&params);
+    for (i = 0; i < sizeof(script) / sizeof(script[0]); i++) {
+        hostAddEvent(script[i].time, script[i].action);
+    }
+    hostStartEvents();
+    hostAddHook(recordHook, CPU_CLOCK_HZ / BENCH_SAMPLE_HZ);
+    if (hostRun(heliMain, (uint64_t)(BENCH_RUN_S * CPU_CLOCK_HZ)) != 0 || homedSample < 0) {
+        fprintf(stderr, "heliBench: the sortie did not complete\n");
+        return EXIT_FAILURE;
+    }
+
+    measureSteps();
+    homingTime = homedSample / (double)BENCH_SAMPLE_HZ - FLY_TIME;
+    landingTime = landedSample >= 0 ? landedSample / (double)BENCH_SAMPLE_HZ - LAND_TIME : -1.0;
+    controlTime = timeControllers();
+
+    printf("{\n"
+           "  \"firmware_flags\": \"%s\",\n"
+           "  \"seed\": %u,\n"
+           "  \"manoeuvres\": [\n", BENCH_FLAGS, params.seed);
+    for (i = 0; i < NUM_MANOEUVRES; i++) {
+        printf("    { \"name\": \"%s\"", manoeuvres[i].name);
+        for (m = 0; m < NUM_STEP_MEASURES; m++) {
+            printf(", \"%s\": %.4f", stepMeasures[m].key, stepResults[i][m]);
+            compare(manoeuvres[i].name, stepMeasures[m].key, stepResults[i][m], tolerance, stepMeasures[m].floor);
+        }
+        printf(" }%s\n", i + 1 < NUM_MANOEUVRES ? "," : "");
+    }
+    printf("  ],\n");
+    printMeasure("homing_time_s", homingTime, false);
+    printMeasure("time_to_land_s", landingTime, false);
+    printMeasure("host_ns_per_control_step", controlTime, true);
+    printf("}\n");
+
+    compare(NULL, "homing_time_s", homingTime, tolerance, 0.02);
+    compare(NULL, "time_to_land_s", landingTime, tolerance, 0.02);
+    compare(NULL, "host_ns_per_control_step", controlTime, TIME_TOLERANCE, TIME_FLOOR_NS);
+    return regressions == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
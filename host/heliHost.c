@@ -0,0 +1,144 @@
+// *******************************************************
+//
+// heliHost.c
+//
+// Runs the unchanged helicopter firmware as a Linux process on the
+// simulated peripherals of hostSim, in virtual time. With -p the
+// firmware flies the simulated rig of heliPlant in closed loop;
+// otherwise the altitude sensor is held at a fixed ADC value and the
+// yaw encoder does not move. Switch, button, reference and serial
+// inputs are injected at set times from the command line. Serial
+// output goes to stdout (-q discards it), the rig state can be
+// logged as CSV with -l, each altitude sensor conversion with -A,
+// and the final OLED contents go to stderr.
+//
+// Build: make -C host
+// Use:   host/heliHost -t 20 -e 1:fly -e 2:home -e 3:up -e 5:p
+//        host/heliHost -p -q -t 600 -l flight.csv -e 1:fly -e 30:up -e 60:left -e 300:land
+//
+// Events are time:action, with time in seconds and an action from
+// hostEvents.h.
+//
+// *******************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "cpuCycles.h"
+#include "hostSim.h"
+#include "hostEvents.h"
+#include "heliPlant.h"
+
+#define HEIGHT_ADC_CHANNEL 9        //AIN9, the altitude sensor
+#define LOG_RATE_HZ 100             //Default rate of rig state log rows
+
+static FILE         *logFile;
+static FILE         *traceFile;
+
+int heliMain(void);
+
+static void
+logHook(void)
+/* Write a row of rig state to the log
+ */
+{
+    const plantState_t *rig = getPlantState();
+
+    fprintf(logFile, "%.4f,%.2f,%.2f,%.1f,%.1f,%.3f,%.3f\n", hostSeconds(), rig->height * 100.0, rig->yaw,
+            rig->mainDuty * 100.0, rig->tailDuty * 100.0, rig->mainSpeed, rig->tailSpeed);
+}
+
+int
+main(int argc, char *argv[])
+{
+    double runTime = 10.0;
+    int heightADC = 2500;
+    bool plant = false;
+    plantParams_t plantParams = plantDefaults;
+    uint32_t logRate = LOG_RATE_HZ;
+    int option;
+    int status;
+    uint8_t line;
+    char *colon;
+
+    while ((option = getopt(argc, argv, "t:a:e:ps:ql:r:A:")) != -1) {
+        switch (option) {
+        case 't':
+            runTime = atof(optarg);
+            break;
+        case 'a':
+            heightADC = atoi(optarg);
+            break;
+        case 'e':
+            colon = strchr(optarg, ':');
+            if (colon == NULL) {
+                fprintf(stderr, "heliHost: event '%s' is not time:action\n", optarg);
+                return EXIT_FAILURE;
+            }
+            *colon = '\0';
+            if (!hostAddEvent(atof(optarg), colon + 1)) {
+                fprintf(stderr, "heliHost: too many events\n");
+                return EXIT_FAILURE;
+            }
+            break;
+        case 'p':
+            plant = true;
+            break;
+        case 's':
+            plantParams.seed = strtoul(optarg, NULL, 0);
+            break;
+        case 'q':
+            hostSetUARTOutput(NULL);
+            break;
+        case 'l':
+            logFile = fopen(optarg, "w");
+            if (logFile == NULL) {
+                perror(optarg);
+                return EXIT_FAILURE;
+            }
+            break;
+        case 'r':
+            logRate = atoi(optarg);
+            break;
+        case 'A':
+            traceFile = fopen(optarg, "w");
+            if (traceFile == NULL) {
+                perror(optarg);
+                return EXIT_FAILURE;
+            }
+            break;
+        default:
+            fprintf(stderr, "Use: %s [-t seconds] [-a heightADC | -p [-s seed] [-l log.csv [-r rateHz]] [-A adc.csv]] [-q]"
+                    " [-e time:action]...\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (plant) {
+        initPlant(&plantParams);
+        setSensorTrace(traceFile);
+    } else {
+        hostSetADC(HEIGHT_ADC_CHANNEL, heightADC);
+    }
+    if (logFile && plant && logRate > 0) {
+        fprintf(logFile, "time_s,height_pct,yaw_deg,main_duty,tail_duty,main_speed,tail_speed\n");
+        hostAddHook(logHook, CPU_CLOCK_HZ / logRate);
+    }
+    hostStartEvents();
+    status = hostRun(heliMain, (uint64_t)(runTime * CPU_CLOCK_HZ));
+
+    fflush(stdout);
+    if (logFile) {
+        fclose(logFile);
+    }
+    if (traceFile) {
+        fclose(traceFile);
+    }
+    for (line = 0; line < 4; line++) {
+        fprintf(stderr, "|%s|\n", hostGetDisplayLine(line));
+    }
+    return status == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,203 @@
+// *******************************************************
+//
+// heliPlant.c
+//
+// Simulated helicopter rig for the host build, stepped from a host
+// hook at PLANT_RATE_HZ.
+//
+// *******************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+#include "inc/hw_memmap.h"
+#include "driverlib/gpio.h"
+#include "driverlib/pwm.h"
+#include "cpuCycles.h"
+#include "motorControl.h"
+#include "heliYaw.h"
+#include "hostSim.h"
+#include "heliPlant.h"
+
+#define HEIGHT_ADC_CHANNEL 9    //AIN9
+#define ADC_VOLTS 3.3
+#define ADC_COUNTS 4096
+#define SENSOR_RANGE_VOLTS 1.0  //Sensor output change over the range of travel
+
+//Encoder state, (B << 1) | A, in order of increasing yaw; B leads A
+static const uint8_t encoderStates[4] = { 0, 2, 3, 1 };
+
+static plantParams_t params;
+static plantState_t state;
+static int32_t      encoderCount;   //Edges sent to the firmware
+static double       mainAlpha;      //Rotor lag filter coefficients for one step
+static double       tailAlpha;
+static uint32_t     noiseState;
+static FILE         *trace;         //Conversions written here if set
+
+const plantParams_t plantDefaults = {
+    0.3,        //mainLag
+    0.2,        //tailLag
+    18.75,      //lift, hovering at 40% main rotor speed
+    3.0,        //gravity
+    1.5,        //heightDamping
+    2000.0,     //tailTorque
+    2531.0,     //mainTorque, balanced at 45% tail rotor speed when hovering
+    2.0,        //yawDamping
+    2.0,        //landedVolts
+    0.005,      //noiseVolts
+    90.0,       //startYaw
+    1           //seed
+};
+
+static double
+noise(void)
+/* Return a normally distributed value with unit standard deviation, from a xorshift generator and the Box-Muller
+ * transform, so runs repeat exactly for a given seed
+ */
+{
+    double u1;
+    double u2;
+
+    noiseState ^= noiseState << 13;
+    noiseState ^= noiseState >> 17;
+    noiseState ^= noiseState << 5;
+    u1 = (noiseState + 1.0) / 4294967297.0;
+    noiseState ^= noiseState << 13;
+    noiseState ^= noiseState >> 17;
+    noiseState ^= noiseState << 5;
+    u2 = noiseState / 4294967296.0;
+    return sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+}
+
+static uint16_t
+sampleSensor(void)
+/* Return a conversion of the altitude sensor output. Called by the simulated ADC for each conversion
+ */
+{
+    double volts = params.landedVolts - state.height * SENSOR_RANGE_VOLTS;
+    double exact = volts / ADC_VOLTS * ADC_COUNTS;
+    long counts = lround((volts + params.noiseVolts * noise()) / ADC_VOLTS * ADC_COUNTS);
+
+    if (counts < 0) {
+        counts = 0;
+    } else if (counts > ADC_COUNTS - 1) {
+        counts = ADC_COUNTS - 1;
+    }
+    if (trace != NULL) {
+        fprintf(trace, "%.6f,%ld,%.3f,%.2f\n", hostSeconds(), counts, exact, state.mainDuty * 100.0);
+    }
+    return (uint16_t)counts;
+}
+
+static void
+stepEncoder(void)
+/* Move the encoder one edge towards the rig's yaw. One edge per step keeps each edge a separate interrupt, as it is
+ * on the rig; at PLANT_RATE_HZ that is good for over 8000 degrees per second. The reference signal pulses low as the
+ * count passes a multiple of ENCODER_COUNTS, the home angle
+ */
+{
+    double target = state.yaw * (ENCODER_COUNTS / 360.0);
+    int32_t last = encoderCount;
+    uint8_t changed;
+
+    if (target >= encoderCount + 0.5) {
+        encoderCount++;
+    } else if (target < encoderCount - 0.5) {
+        encoderCount--;
+    } else {
+        return;
+    }
+    changed = encoderStates[last & 3] ^ encoderStates[encoderCount & 3];
+    if (changed & 1) {
+        hostSetPin(GPIO_PORTB_BASE, ENCODER_A_PIN, encoderStates[encoderCount & 3] & 1);
+    } else {
+        hostSetPin(GPIO_PORTB_BASE, ENCODER_B_PIN, encoderStates[encoderCount & 3] & 2);
+    }
+    hostQEIMove(encoderCount - last);
+    if (encoderCount % ENCODER_COUNTS == 0) {
+        hostSetPin(GPIO_PORTC_BASE, REF_PIN, false);
+        hostSetPin(GPIO_PORTC_BASE, REF_PIN, true);
+        hostQEIIndex();
+    }
+}
+
+static void
+plantStep(void)
+/* Advance the rig by one step, with the duty cycles the firmware is applying now
+ */
+{
+    const double dt = 1.0 / PLANT_RATE_HZ;
+    double accel;
+
+    state.mainDuty = hostGetPWMDuty(PWM_MAIN_BASE, PWM_MAIN_OUTNUM);
+    state.tailDuty = hostGetPWMDuty(PWM_TAIL_BASE, PWM_TAIL_OUTNUM);
+    state.mainSpeed += (state.mainDuty - state.mainSpeed) * mainAlpha;
+    state.tailSpeed += (state.tailDuty - state.tailSpeed) * tailAlpha;
+
+    //Height, resting on the ground or the top of travel when pushed against it
+    accel = params.lift * state.mainSpeed * state.mainSpeed - params.gravity - params.heightDamping * state.heightRate;
+    state.heightRate += accel * dt;
+    state.height += state.heightRate * dt;
+    if (state.height <= 0.0) {
+        state.height = 0.0;
+        if (state.heightRate < 0.0) {
+            state.heightRate = 0.0;
+        }
+    } else if (state.height >= 1.0) {
+        state.height = 1.0;
+        if (state.heightRate > 0.0) {
+            state.heightRate = 0.0;
+        }
+    }
+
+    //Yaw
+    accel = params.tailTorque * state.tailSpeed * state.tailSpeed
+            - params.mainTorque * state.mainSpeed * state.mainSpeed - params.yawDamping * state.yawRate;
+    state.yawRate += accel * dt;
+    state.yaw += state.yawRate * dt;
+
+    stepEncoder();
+}
+
+void
+initPlant(const plantParams_t *plantParams)
+/* Set the rig landed at the start yaw and start stepping it. Call before hostRun
+ */
+{
+    params = *plantParams;
+    state.height = 0.0;
+    state.heightRate = 0.0;
+    state.yaw = params.startYaw;
+    state.yawRate = 0.0;
+    state.mainSpeed = 0.0;
+    state.tailSpeed = 0.0;
+    encoderCount = (int32_t)floor(state.yaw * ENCODER_COUNTS / 360.0 + 0.5);
+    noiseState = params.seed ? params.seed : 1;
+    mainAlpha = 1.0 / (PLANT_RATE_HZ * params.mainLag);
+    tailAlpha = 1.0 / (PLANT_RATE_HZ * params.tailLag);
+
+    hostSetPin(GPIO_PORTB_BASE, ENCODER_A_PIN, encoderStates[encoderCount & 3] & 1);
+    hostSetPin(GPIO_PORTB_BASE, ENCODER_B_PIN, encoderStates[encoderCount & 3] & 2);
+    hostSetPin(GPIO_PORTC_BASE, REF_PIN, true);
+    hostSetADCSource(HEIGHT_ADC_CHANNEL, sampleSensor);
+    hostAddHook(plantStep, CPU_CLOCK_HZ / PLANT_RATE_HZ);
+}
+
+const plantState_t *
+getPlantState(void)
+{
+    return &state;
+}
+
+void
+setSensorTrace(FILE *file)
+/* Write each conversion of the altitude sensor to file as a row of time_s,adc,true_adc,main_duty, where true_adc is
+ * the noise free sensor output in counts and main_duty the main rotor duty in percent. Rows follow a header line
+ */
+{
+    trace = file;
+    if (trace != NULL) {
+        fprintf(trace, "time_s,adc,true_adc,main_duty\n");
+    }
+}
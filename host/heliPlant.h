@@ -0,0 +1,69 @@
+// *******************************************************
+//
+// heliPlant.h
+//
+// Simulated helicopter rig for the host build. Reads the main and
+// tail rotor duty cycles from the simulated PWM outputs and drives
+// the altitude sensor input, the quadrature encoder and the yaw
+// reference signal, so the unchanged firmware flies it in closed
+// loop in virtual time.
+//
+// Model:
+//  - Each rotor's speed follows its duty cycle with a first order lag.
+//  - Lift goes with main rotor speed squared, against gravity and
+//    damping. The rig is limited to its range of travel, with the
+//    ground at 0 and the top at 1.
+//  - The tail rotor torque goes with tail speed squared. The main
+//    rotor's reaction torque goes with main speed squared and turns
+//    the other way. Both act on the yaw inertia with damping.
+//  - The altitude sensor falls by 1 V over the range of travel.
+//  - The encoder gives ENCODER_COUNTS edges per revolution, and the
+//    reference signal pulses low as the rig passes the home angle.
+//
+// *******************************************************
+
+#ifndef HELIPLANT_H
+#define HELIPLANT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#define PLANT_RATE_HZ 10000     //Integration steps per second of virtual time
+#define ENCODER_COUNTS 448      //Encoder edges per revolution
+
+typedef struct {
+    double mainLag;             //Main rotor speed time constant (s)
+    double tailLag;             //Tail rotor speed time constant (s)
+    double lift;                //Acceleration at full main rotor speed (range/s^2)
+    double gravity;             //Acceleration due to the rig's weight (range/s^2)
+    double heightDamping;       //Vertical damping (1/s)
+    double tailTorque;          //Yaw acceleration at full tail rotor speed (deg/s^2)
+    double mainTorque;          //Yaw acceleration from full main rotor speed, opposing the tail (deg/s^2)
+    double yawDamping;          //Yaw damping (1/s)
+    double landedVolts;         //Altitude sensor output on the ground (V)
+    double noiseVolts;          //Standard deviation of altitude sensor noise (V)
+    double startYaw;            //Yaw at start, relative to the home angle (deg)
+    uint32_t seed;              //Sensor noise seed
+} plantParams_t;
+
+typedef struct {
+    double height;              //Fraction of the range of travel
+    double heightRate;
+    double yaw;                 //Degrees from the home angle, unwrapped
+    double yawRate;
+    double mainSpeed;           //Rotor speeds as a fraction of full speed
+    double tailSpeed;
+    double mainDuty;            //Duty cycles applied by the firmware, as a fraction
+    double tailDuty;
+} plantState_t;
+
+extern const plantParams_t plantDefaults;
+
+void initPlant(const plantParams_t *params);
+
+const plantState_t *getPlantState(void);
+
+void setSensorTrace(FILE *file);
+
+#endif /*HELIPLANT_H*/
@@ -0,0 +1,22 @@
+// *******************************************************
+//
+// hostClock.c
+//
+// Wall clock time on the host, for the benchmarks.
+//
+// *******************************************************
+
+#include <stdint.h>
+#include <time.h>
+#include "hostClock.h"
+
+uint64_t
+hostNanoseconds(void)
+/* Return the host monotonic clock in nanoseconds
+ */
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
@@ -0,0 +1,19 @@
+// *******************************************************
+//
+// hostClock.h
+//
+// Wall clock time on the host, in nanoseconds from the monotonic
+// clock, for the benchmarks to time host code with. Unlike the host
+// build of cpuCycles it is not scaled to a target clock, as the host
+// runs the code at its own speed.
+//
+// *******************************************************
+
+#ifndef HOSTCLOCK_H
+#define HOSTCLOCK_H
+
+#include <stdint.h>
+
+uint64_t hostNanoseconds(void);
+
+#endif /*HOSTCLOCK_H*/
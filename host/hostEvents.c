@@ -0,0 +1,129 @@
+// *******************************************************
+//
+// hostEvents.c
+//
+// Timed inputs for the host build, run from a host hook at
+// EVENT_RATE_HZ.
+//
+// *******************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "inc/hw_memmap.h"
+#include "driverlib/gpio.h"
+#include "cpuCycles.h"
+#include "buttons4.h"
+#include "hostSim.h"
+#include "hostEvents.h"
+
+typedef struct {
+    double time;
+    const char *action;
+    bool release;                   //Second half of a button press
+} hostEvent_t;
+
+static hostEvent_t  events[HOST_MAX_EVENTS];
+static uint8_t      eventCount;
+static uint8_t      nextEvent;
+
+static bool
+insertEvent(double time, const char *action, bool release)
+/* Insert an event, keeping the list in time order. Return false if the list is full
+ */
+{
+    uint8_t i = eventCount;
+
+    if (eventCount == HOST_MAX_EVENTS) {
+        return false;
+    }
+    while (i > 0 && events[i - 1].time > time) {
+        events[i] = events[i - 1];
+        i--;
+    }
+    events[i].time = time;
+    events[i].action = action;
+    events[i].release = release;
+    eventCount++;
+    return true;
+}
+
+static bool
+buttonPin(const char *action, uint32_t *port, uint8_t *pin, bool *normal)
+{
+    if (strcmp(action, "up") == 0) {
+        *port = UP_BUT_PORT_BASE; *pin = UP_BUT_PIN; *normal = UP_BUT_NORMAL;
+    } else if (strcmp(action, "down") == 0) {
+        *port = DOWN_BUT_PORT_BASE; *pin = DOWN_BUT_PIN; *normal = DOWN_BUT_NORMAL;
+    } else if (strcmp(action, "left") == 0) {
+        *port = LEFT_BUT_PORT_BASE; *pin = LEFT_BUT_PIN; *normal = LEFT_BUT_NORMAL;
+    } else if (strcmp(action, "right") == 0) {
+        *port = RIGHT_BUT_PORT_BASE; *pin = RIGHT_BUT_PIN; *normal = RIGHT_BUT_NORMAL;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static void
+runEvent(const hostEvent_t *event)
+{
+    uint32_t port;
+    uint8_t pin;
+    bool normal;
+
+    if (strcmp(event->action, "fly") == 0 || strcmp(event->action, "land") == 0) {
+        hostSetPin(GPIO_PORTA_BASE, GPIO_PIN_7, event->action[0] == 'f');
+    } else if (strcmp(event->action, "home") == 0) {
+        //The reference signal is active low. It reaches the QEI index input in the YAW_USE_QEI build
+        hostSetPin(GPIO_PORTC_BASE, GPIO_PIN_4, false);
+        hostSetPin(GPIO_PORTC_BASE, GPIO_PIN_4, true);
+        hostQEIIndex();
+    } else if (buttonPin(event->action, &port, &pin, &normal)) {
+        hostSetPin(port, pin, event->release ? normal : !normal);
+    } else {
+        hostUARTInput(event->action);
+    }
+}
+
+static void
+eventHook(void)
+/* Run the events that have come due
+ */
+{
+    double now = hostSeconds();
+
+    while (nextEvent < eventCount && events[nextEvent].time <= now) {
+        runEvent(&events[nextEvent++]);
+    }
+}
+
+bool
+hostAddEvent(double time, const char *action)
+/* Add an action at a time in seconds. A button press is added as a press and a release BUTTON_PRESS_S later.
+ * The action text is not copied. Return false if the event list is full
+ */
+{
+    uint32_t port;
+    uint8_t pin;
+    bool normal;
+
+    if (buttonPin(action, &port, &pin, &normal) && eventCount == HOST_MAX_EVENTS - 1) {
+        return false;
+    }
+    if (!insertEvent(time, action, false)) {
+        return false;
+    }
+    if (buttonPin(action, &port, &pin, &normal)) {
+        insertEvent(time + BUTTON_PRESS_S, action, true);
+    }
+    return true;
+}
+
+void
+hostStartEvents(void)
+/* Start running the events. Call before hostRun
+ */
+{
+    hostAddHook(eventHook, CPU_CLOCK_HZ / EVENT_RATE_HZ);
+}
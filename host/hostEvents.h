@@ -0,0 +1,31 @@
+// *******************************************************
+//
+// hostEvents.h
+//
+// Timed inputs for the host build: the flight switch, buttons, the
+// yaw reference signal and serial input, injected at set times of
+// virtual time while the firmware runs.
+//
+// Actions are
+//   fly, land          SW1 up or down
+//   home               pulse the yaw reference signal
+//   up, down, left, right   press a button for 100 ms
+//   any other text     sent to the serial port
+//
+// *******************************************************
+
+#ifndef HOSTEVENTS_H
+#define HOSTEVENTS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define HOST_MAX_EVENTS 64
+#define EVENT_RATE_HZ 1000          //Resolution of event times
+#define BUTTON_PRESS_S 0.1
+
+bool hostAddEvent(double time, const char *action);
+
+void hostStartEvents(void);
+
+#endif /*HOSTEVENTS_H*/
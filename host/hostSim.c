@@ -0,0 +1,1514 @@
+// *******************************************************
+//
+// hostSim.c
+//
+// Simulated TM4C123 peripherals and virtual time for the host build.
+// Implements the driverlib functions the firmware uses.
+//
+// *******************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <setjmp.h>
+#include "inc/hw_memmap.h"
+#include "inc/hw_types.h"
+#include "inc/hw_ints.h"
+#include "driverlib/adc.h"
+#include "driverlib/gpio.h"
+#include "driverlib/interrupt.h"
+#include "driverlib/pwm.h"
+#include "driverlib/qei.h"
+#include "driverlib/sysctl.h"
+#include "driverlib/systick.h"
+#include "driverlib/timer.h"
+#include "driverlib/uart.h"
+#include "driverlib/udma.h"
+#include "cpuCycles.h"
+#include "hostSim.h"
+
+#define NUM_INTS        64
+#define NUM_PORTS       6
+#define NUM_TIMERS      4
+#define NUM_SEQUENCES   4
+#define ADC_FIFO_DEPTH  8
+#define NUM_PWM_OUTS    8
+#define NUM_DMA_CHANNELS 32
+#define NUM_REGS        64
+#define UART_RX_SIZE    256
+#define UART_TX_FIFO    16      //Tx FIFO depth
+#define UART_BITS       10      //Start, eight data and stop bits on the line per byte
+
+//*****************************************************************************
+// Simulator state
+//*****************************************************************************
+//Virtual time and run control
+static uint64_t     now;
+static uint64_t     endTime;
+static jmp_buf      runExit;
+static bool         running;
+
+typedef struct {
+    hostHook_t hook;
+    uint32_t period;
+    uint64_t next;
+} hostHookState_t;
+
+static hostHookState_t hooks[HOST_MAX_HOOKS];
+static uint8_t      hookCount;
+
+//NVIC
+static void         (*handlers[NUM_INTS])(void);
+static uint64_t     intEnabled;             //One bit per interrupt number
+static uint64_t     intPending;
+static bool         masterDisabled;         //PRIMASK, clear at reset
+static bool         inHandler;
+
+//SysTick
+static uint32_t     sysTickPeriod;
+static bool         sysTickRunning;
+static bool         sysTickIntOn;
+static uint64_t     sysTickNext;
+
+//General purpose timers, A half only
+typedef struct {
+    uint32_t load;
+    bool running;
+    bool adcTrigger;
+    uint32_t intMask;
+    uint32_t rawInt;
+    uint64_t next;
+} hostTimer_t;
+
+static hostTimer_t  timers[NUM_TIMERS];
+
+//GPIO ports A-F
+typedef struct {
+    uint8_t level;          //Levels driven by the host
+    uint8_t driven;         //Pins driven by the host, the rest float to their pull
+    uint8_t pullUp;
+    uint8_t intMask;
+    uint8_t bothEdges;
+    uint8_t risingEdge;
+    uint8_t rawInt;
+} hostPort_t;
+
+static hostPort_t   ports[NUM_PORTS];
+
+//ADC0
+typedef struct {
+    uint32_t trigger;
+    bool enabled;
+    bool dma;
+    uint32_t step;          //Step 0 configuration
+    uint32_t fifo[ADC_FIFO_DEPTH];
+    uint8_t fifoCount;
+} hostSequence_t;
+
+static hostSequence_t sequences[NUM_SEQUENCES];
+static uint16_t     adcInput[16];
+static uint16_t     (*adcSource[16])(void);
+static uint32_t     adcIntMask;
+static uint32_t     adcAverage = 1;     //Conversions averaged in hardware for each sample
+static uint32_t     adcRawInt;
+
+//PWM0 and PWM1
+typedef struct {
+    uint32_t period[4];
+    bool genEnabled[4];
+    uint32_t width[NUM_PWM_OUTS];
+    uint8_t outEnabled;
+} hostPWM_t;
+
+static hostPWM_t    pwm[2];
+
+//QEI0
+static uint32_t     qeiPosition;
+static uint32_t     qeiMaxPosition = 0xFFFFFFFF;
+static uint32_t     qeiIntMask;
+static uint32_t     qeiRawInt;
+
+//UART0
+static void         (*uartOutput)(uint8_t byte);
+static bool         uartOutputSet;
+static uint32_t     uartIntMask;
+static uint32_t     uartRawInt;
+static char         uartRx[UART_RX_SIZE];
+static uint32_t     uartRxHead;
+static uint32_t     uartRxTail;
+static bool         uartTxStalled;
+static bool         uartTxPaced;
+static uint32_t     uartBaud = 9600;
+static uint32_t     uartTxLevel = UART_TX_FIFO / 8;   //Tx interrupt once the FIFO drains to this
+static uint32_t     uartTxCount;    //Bytes in the Tx FIFO on a paced line
+static uint64_t     uartTxNext;     //Time the byte going out on a paced line is sent
+
+//uDMA, primary and alternate control structures of each channel
+typedef struct {
+    uint32_t mode;
+    uint32_t control;
+    uint8_t *src;
+    uint8_t *dst;
+    uint32_t count;
+} hostDMAControl_t;
+
+static hostDMAControl_t dmaControl[NUM_DMA_CHANNELS][2];
+static bool         dmaEnabled[NUM_DMA_CHANNELS];
+static bool         dmaUseAlt[NUM_DMA_CHANNELS];
+
+//Registers accessed through HWREG
+static uint32_t     regAddr[NUM_REGS];
+static uint32_t     regValue[NUM_REGS];
+static uint8_t      regCount;
+
+//*****************************************************************************
+// Interrupts
+//*****************************************************************************
+static uint32_t portInterrupt(uint8_t n);
+static uint32_t timerInterrupt(uint8_t n);
+
+static bool
+levelAsserted(uint32_t interrupt)
+/* Return whether the peripheral behind a level-sensitive interrupt still asserts it, so that a handler
+ * that does not clear its source is entered again, as on the part
+ */
+{
+    uint8_t i;
+
+    for (i = 0; i < NUM_PORTS; i++) {
+        if (interrupt == portInterrupt(i)) {
+            return (ports[i].rawInt & ports[i].intMask) != 0;
+        }
+    }
+    for (i = 0; i < NUM_TIMERS; i++) {
+        if (interrupt == timerInterrupt(i)) {
+            return (timers[i].rawInt & timers[i].intMask) != 0;
+        }
+    }
+    if (interrupt >= INT_ADC0SS0 && interrupt <= INT_ADC0SS3) {
+        i = interrupt - INT_ADC0SS0;
+        return (adcRawInt & adcIntMask & ((1u << i) | (ADC_INT_DMA_SS0 << i))) != 0;
+    }
+    if (interrupt == INT_QEI0) {
+        return (qeiRawInt & qeiIntMask) != 0;
+    }
+    if (interrupt == INT_UART0) {
+        return (uartRawInt & uartIntMask) != 0;
+    }
+    return false;
+}
+
+static void
+updateInterrupt(uint32_t interrupt)
+/* Latch an interrupt as pending if its peripheral asserts it
+ */
+{
+    if (levelAsserted(interrupt)) {
+        intPending |= 1ull << interrupt;
+    }
+}
+
+static bool
+interruptWaiting(void)
+{
+    return (intPending & intEnabled) != 0;
+}
+
+static void
+dispatchInterrupts(void)
+/* Run the handlers of all pending, enabled interrupts, lowest number first, while interrupts are unmasked. Handlers
+ * run to completion; anything they raise is taken once they return
+ */
+{
+    uint32_t i;
+
+    if (inHandler || masterDisabled) {
+        return;
+    }
+    inHandler = true;
+    while ((intPending & intEnabled) != 0 && !masterDisabled) {
+        i = __builtin_ctzll(intPending & intEnabled);
+        intPending &= ~(1ull << i);
+        if (handlers[i] == 0) {
+            fprintf(stderr, "hostSim: interrupt %u has no handler\n", i);
+            exit(EXIT_FAILURE);
+        }
+        handlers[i]();
+        updateInterrupt(i);
+    }
+    inHandler = false;
+}
+
+void
+hostRaise(uint32_t interrupt)
+/* Inject an interrupt, as if its peripheral had requested it
+ */
+{
+    intPending |= 1ull << interrupt;
+    dispatchInterrupts();
+}
+
+bool
+IntMasterEnable(void)
+{
+    bool wasDisabled = masterDisabled;
+
+    masterDisabled = false;
+    dispatchInterrupts();
+    return wasDisabled;
+}
+
+bool
+IntMasterDisable(void)
+{
+    bool wasDisabled = masterDisabled;
+
+    masterDisabled = true;
+    return wasDisabled;
+}
+
+void
+IntRegister(uint32_t ui32Interrupt, void (*pfnHandler)(void))
+{
+    handlers[ui32Interrupt] = pfnHandler;
+}
+
+void
+IntEnable(uint32_t ui32Interrupt)
+{
+    intEnabled |= 1ull << ui32Interrupt;
+    dispatchInterrupts();
+}
+
+void
+IntDisable(uint32_t ui32Interrupt)
+{
+    intEnabled &= ~(1ull << ui32Interrupt);
+}
+
+void
+IntPrioritySet(uint32_t ui32Interrupt, uint8_t ui8Priority)
+{
+}
+
+//*****************************************************************************
+// Registers accessed through HWREG, e.g. GPIO unlock and the DWT
+//*****************************************************************************
+volatile uint32_t *
+hostReg(uint32_t ui32Addr)
+{
+    uint8_t i;
+
+    for (i = 0; i < regCount; i++) {
+        if (regAddr[i] == ui32Addr) {
+            return &regValue[i];
+        }
+    }
+    if (regCount == NUM_REGS) {
+        fprintf(stderr, "hostSim: too many registers accessed through HWREG\n");
+        exit(EXIT_FAILURE);
+    }
+    regAddr[regCount] = ui32Addr;
+    regValue[regCount] = 0;
+    return &regValue[regCount++];
+}
+
+//*****************************************************************************
+// Virtual time
+//*****************************************************************************
+static void convertSequence(uint8_t sequence);
+
+static void
+timerTimeout(uint8_t n)
+{
+    uint8_t i;
+
+    timers[n].next += (uint64_t)timers[n].load + 1;
+    timers[n].rawInt |= TIMER_TIMA_TIMEOUT;
+    if (timers[n].adcTrigger) {
+        for (i = 0; i < NUM_SEQUENCES; i++) {
+            if (sequences[i].enabled && sequences[i].trigger == ADC_TRIGGER_TIMER) {
+                convertSequence(i);
+            }
+        }
+    }
+    updateInterrupt(timerInterrupt(n));
+}
+
+static uint64_t
+nextEvent(void)
+/* Return the time of the next timer, SysTick or hook event, or UINT64_MAX if nothing is running
+ */
+{
+    uint64_t next = UINT64_MAX;
+    uint8_t i;
+
+    if (sysTickRunning && sysTickNext < next) {
+        next = sysTickNext;
+    }
+    for (i = 0; i < NUM_TIMERS; i++) {
+        if (timers[i].running && timers[i].next < next) {
+            next = timers[i].next;
+        }
+    }
+    for (i = 0; i < hookCount; i++) {
+        if (hooks[i].next < next) {
+            next = hooks[i].next;
+        }
+    }
+    if (uartTxCount > 0 && uartTxNext < next) {
+        next = uartTxNext;
+    }
+    return next;
+}
+
+static void uartLineSent(void);
+
+static void
+advance(uint64_t limit)
+/* Move time to the next event, or to limit if that is sooner, and process every event due then. Host hooks run first
+ * so the firmware sees their inputs. Interrupts raised are left pending for the caller to dispatch
+ */
+{
+    uint64_t next = nextEvent();
+    uint8_t i;
+
+    if (next > limit) {
+        next = limit;
+    }
+    if (next >= endTime) {
+        now = endTime;
+        longjmp(runExit, 1);
+    }
+    if (next == UINT64_MAX) {
+        fprintf(stderr, "hostSim: firmware is asleep with nothing running to wake it\n");
+        longjmp(runExit, 2);
+    }
+    now = next;
+
+    inHandler = true;   //Hold off dispatch while the hooks change inputs
+    for (i = 0; i < hookCount; i++) {
+        if (hooks[i].next == now) {
+            hooks[i].next += hooks[i].period;
+            hooks[i].hook();
+        }
+    }
+    inHandler = false;
+    if (sysTickRunning && sysTickNext == now) {
+        sysTickNext += sysTickPeriod;
+        if (sysTickIntOn) {
+            intPending |= 1ull << FAULT_SYSTICK;
+        }
+    }
+    for (i = 0; i < NUM_TIMERS; i++) {
+        if (timers[i].running && timers[i].next == now) {
+            timerTimeout(i);
+        }
+    }
+    if (uartTxCount > 0 && uartTxNext == now) {
+        uartLineSent();
+    }
+}
+
+int
+hostRun(int (*entry)(void), uint64_t cycles)
+/* Run entry, normally the firmware main(), for the given number of cycles of virtual time. Returns 0 when the time is
+ * up, 1 if entry returned and 2 if the firmware went to sleep with no event left to wake it
+ */
+{
+    int status;
+
+    endTime = now + cycles;
+    running = true;
+    status = setjmp(runExit);
+    if (status == 0) {
+        entry();
+        status = 1;
+    } else if (status == 1) {
+        status = 0;
+    }
+    running = false;
+    inHandler = false;
+    return status;
+}
+
+void
+hostStop(void)
+/* End the run now. May be called from a hook or handler
+ */
+{
+    if (running) {
+        longjmp(runExit, 1);
+    }
+}
+
+uint64_t
+hostTime(void)
+{
+    return now;
+}
+
+double
+hostSeconds(void)
+{
+    return (double)now / CPU_CLOCK_HZ;
+}
+
+void
+hostAddHook(hostHook_t hook, uint32_t periodCycles)
+/* Call hook every periodCycles of virtual time, starting one period from now
+ */
+{
+    if (hookCount == HOST_MAX_HOOKS) {
+        fprintf(stderr, "hostSim: too many hooks\n");
+        exit(EXIT_FAILURE);
+    }
+    hooks[hookCount].hook = hook;
+    hooks[hookCount].period = periodCycles;
+    hooks[hookCount].next = now + periodCycles;
+    hookCount++;
+}
+
+//*****************************************************************************
+// System control
+//*****************************************************************************
+void
+SysCtlSleep(void)
+/* WFI: wake once an enabled interrupt is pending, then take it if interrupts are unmasked
+ */
+{
+    while (!interruptWaiting()) {
+        advance(UINT64_MAX);
+    }
+    dispatchInterrupts();
+}
+
+void
+SysCtlDelay(uint32_t ui32Count)
+/* Busy wait of three cycles per count, taking interrupts as they arrive
+ */
+{
+    uint64_t until = now + 3 * (uint64_t)ui32Count;
+
+    while (now < until) {
+        advance(until);
+        dispatchInterrupts();
+    }
+}
+
+void
+SysCtlPeripheralEnable(uint32_t ui32Peripheral)
+{
+}
+
+void
+SysCtlPeripheralReset(uint32_t ui32Peripheral)
+{
+}
+
+bool
+SysCtlPeripheralReady(uint32_t ui32Peripheral)
+{
+    return true;
+}
+
+void
+SysCtlClockSet(uint32_t ui32Config)
+{
+}
+
+uint32_t
+SysCtlClockGet(void)
+{
+    return CPU_CLOCK_HZ;
+}
+
+void
+SysCtlPWMClockSet(uint32_t ui32Config)
+{
+}
+
+//*****************************************************************************
+// SysTick
+//*****************************************************************************
+void
+SysTickEnable(void)
+{
+    sysTickRunning = true;
+    sysTickNext = now + sysTickPeriod;
+}
+
+void
+SysTickDisable(void)
+{
+    sysTickRunning = false;
+}
+
+void
+SysTickIntRegister(void (*pfnHandler)(void))
+{
+    handlers[FAULT_SYSTICK] = pfnHandler;
+    intEnabled |= 1ull << FAULT_SYSTICK;
+}
+
+void
+SysTickIntEnable(void)
+{
+    sysTickIntOn = true;
+}
+
+void
+SysTickIntDisable(void)
+{
+    sysTickIntOn = false;
+}
+
+void
+SysTickPeriodSet(uint32_t ui32Period)
+{
+    sysTickPeriod = ui32Period;
+}
+
+uint32_t
+SysTickPeriodGet(void)
+{
+    return sysTickPeriod;
+}
+
+uint32_t
+SysTickValueGet(void)
+{
+    if (!sysTickRunning) {
+        return 0;
+    }
+    return (uint32_t)(sysTickNext - now - 1);
+}
+
+//*****************************************************************************
+// General purpose timers
+//*****************************************************************************
+static uint8_t
+timerIndex(uint32_t base)
+{
+    return (base - TIMER0_BASE) >> 12;
+}
+
+static uint32_t
+timerInterrupt(uint8_t n)
+{
+    static const uint32_t timerInts[NUM_TIMERS] = { INT_TIMER0A, INT_TIMER1A, INT_TIMER2A, INT_TIMER3A };
+
+    return timerInts[n];
+}
+
+void
+TimerConfigure(uint32_t ui32Base, uint32_t ui32Config)
+{
+    timers[timerIndex(ui32Base)].running = false;
+}
+
+void
+TimerLoadSet(uint32_t ui32Base, uint32_t ui32Timer, uint32_t ui32Value)
+{
+    timers[timerIndex(ui32Base)].load = ui32Value;
+}
+
+uint32_t
+TimerValueGet(uint32_t ui32Base, uint32_t ui32Timer)
+/* The timer counts down from the load value, so the value is the cycles left to the next timeout less one
+ */
+{
+    hostTimer_t *timer = &timers[timerIndex(ui32Base)];
+
+    if (!timer->running) {
+        return timer->load;
+    }
+    return (uint32_t)(timer->next - now - 1);
+}
+
+void
+TimerEnable(uint32_t ui32Base, uint32_t ui32Timer)
+{
+    hostTimer_t *timer = &timers[timerIndex(ui32Base)];
+
+    timer->running = true;
+    timer->next = now + (uint64_t)timer->load + 1;
+}
+
+void
+TimerDisable(uint32_t ui32Base, uint32_t ui32Timer)
+{
+    timers[timerIndex(ui32Base)].running = false;
+}
+
+void
+TimerControlTrigger(uint32_t ui32Base, uint32_t ui32Timer, bool bEnable)
+{
+    timers[timerIndex(ui32Base)].adcTrigger = bEnable;
+}
+
+void
+TimerADCEventSet(uint32_t ui32Base, uint32_t ui32ADCEvent)
+{
+}
+
+void
+TimerIntRegister(uint32_t ui32Base, uint32_t ui32Timer, void (*pfnHandler)(void))
+{
+    uint32_t interrupt = timerInterrupt(timerIndex(ui32Base));
+
+    handlers[interrupt] = pfnHandler;
+    IntEnable(interrupt);
+}
+
+void
+TimerIntEnable(uint32_t ui32Base, uint32_t ui32IntFlags)
+{
+    uint8_t n = timerIndex(ui32Base);
+
+    timers[n].intMask |= ui32IntFlags;
+    updateInterrupt(timerInterrupt(n));
+}
+
+void
+TimerIntClear(uint32_t ui32Base, uint32_t ui32IntFlags)
+{
+    timers[timerIndex(ui32Base)].rawInt &= ~ui32IntFlags;
+}
+
+//*****************************************************************************
+// GPIO
+//*****************************************************************************
+static uint8_t
+portIndex(uint32_t base)
+{
+    switch (base) {
+    case GPIO_PORTA_BASE: return 0;
+    case GPIO_PORTB_BASE: return 1;
+    case GPIO_PORTC_BASE: return 2;
+    case GPIO_PORTD_BASE: return 3;
+    case GPIO_PORTE_BASE: return 4;
+    case GPIO_PORTF_BASE: return 5;
+    }
+    fprintf(stderr, "hostSim: unknown GPIO port 0x%08x\n", base);
+    exit(EXIT_FAILURE);
+}
+
+static uint32_t
+portInterrupt(uint8_t n)
+{
+    static const uint32_t portInts[NUM_PORTS] = { INT_GPIOA, INT_GPIOB, INT_GPIOC, INT_GPIOD, INT_GPIOE, INT_GPIOF };
+
+    return portInts[n];
+}
+
+static uint8_t
+portLevels(const hostPort_t *port)
+{
+    return (port->level & port->driven) | (port->pullUp & ~port->driven);
+}
+
+static void
+setPortLevels(uint8_t n, uint8_t levels, uint8_t driven)
+/* Drive pins to new levels and latch the edge interrupts they cause. Without GPIOIntTypeSet a pin interrupts on
+ * falling edges, the reset setting
+ */
+{
+    hostPort_t *port = &ports[n];
+    uint8_t before = portLevels(port);
+    uint8_t after;
+    uint8_t changed;
+
+    port->level = (port->level & ~driven) | (levels & driven);
+    port->driven |= driven;
+    after = portLevels(port);
+    changed = before ^ after;
+    port->rawInt |= changed & (port->bothEdges | (port->risingEdge & after) | (~port->risingEdge & ~after));
+    updateInterrupt(portInterrupt(n));
+}
+
+void
+hostSetPin(uint32_t portBase, uint8_t pins, bool high)
+{
+    setPortLevels(portIndex(portBase), high ? pins : 0, pins);
+    dispatchInterrupts();
+}
+
+bool
+hostGetPin(uint32_t portBase, uint8_t pin)
+{
+    return (portLevels(&ports[portIndex(portBase)]) & pin) != 0;
+}
+
+void
+GPIOPinTypeGPIOInput(uint32_t ui32Port, uint8_t ui8Pins)
+{
+}
+
+void
+GPIOPinTypeGPIOOutput(uint32_t ui32Port, uint8_t ui8Pins)
+{
+}
+
+void
+GPIOPinTypePWM(uint32_t ui32Port, uint8_t ui8Pins)
+{
+}
+
+void
+GPIOPinTypeUART(uint32_t ui32Port, uint8_t ui8Pins)
+{
+}
+
+void
+GPIOPinTypeQEI(uint32_t ui32Port, uint8_t ui8Pins)
+{
+}
+
+void
+GPIOPinConfigure(uint32_t ui32PinConfig)
+{
+}
+
+void
+GPIOPadConfigSet(uint32_t ui32Port, uint8_t ui8Pins, uint32_t ui32Strength, uint32_t ui32PadType)
+/* Undriven pins float to their pull-up or pull-down. They are taken to have been there since reset, so setting the
+ * pull does not cause an edge
+ */
+{
+    uint8_t n = portIndex(ui32Port);
+
+    if (ui32PadType == GPIO_PIN_TYPE_STD_WPU) {
+        ports[n].pullUp |= ui8Pins;
+    } else {
+        ports[n].pullUp &= ~ui8Pins;
+    }
+}
+
+int32_t
+GPIOPinRead(uint32_t ui32Port, uint8_t ui8Pins)
+{
+    return portLevels(&ports[portIndex(ui32Port)]) & ui8Pins;
+}
+
+void
+GPIOPinWrite(uint32_t ui32Port, uint8_t ui8Pins, uint8_t ui8Val)
+{
+    setPortLevels(portIndex(ui32Port), ui8Val, ui8Pins);
+}
+
+void
+GPIOIntRegister(uint32_t ui32Port, void (*pfnIntHandler)(void))
+{
+    uint32_t interrupt = portInterrupt(portIndex(ui32Port));
+
+    handlers[interrupt] = pfnIntHandler;
+    IntEnable(interrupt);
+}
+
+void
+GPIOIntEnable(uint32_t ui32Port, uint32_t ui32IntFlags)
+{
+    uint8_t n = portIndex(ui32Port);
+
+    ports[n].intMask |= ui32IntFlags;
+    updateInterrupt(portInterrupt(n));
+    dispatchInterrupts();
+}
+
+void
+GPIOIntDisable(uint32_t ui32Port, uint32_t ui32IntFlags)
+{
+    ports[portIndex(ui32Port)].intMask &= ~ui32IntFlags;
+}
+
+void
+GPIOIntClear(uint32_t ui32Port, uint32_t ui32IntFlags)
+{
+    ports[portIndex(ui32Port)].rawInt &= ~ui32IntFlags;
+}
+
+uint32_t
+GPIOIntStatus(uint32_t ui32Port, bool bMasked)
+{
+    hostPort_t *port = &ports[portIndex(ui32Port)];
+
+    return bMasked ? port->rawInt & port->intMask : port->rawInt;
+}
+
+void
+GPIOIntTypeSet(uint32_t ui32Port, uint8_t ui8Pins, uint32_t ui32IntType)
+{
+    hostPort_t *port = &ports[portIndex(ui32Port)];
+
+    port->bothEdges &= ~ui8Pins;
+    port->risingEdge &= ~ui8Pins;
+    if (ui32IntType == GPIO_BOTH_EDGES) {
+        port->bothEdges |= ui8Pins;
+    } else if (ui32IntType == GPIO_RISING_EDGE) {
+        port->risingEdge |= ui8Pins;
+    }
+}
+
+//*****************************************************************************
+// uDMA
+//*****************************************************************************
+static uint32_t
+dmaSrcIncrement(uint32_t control)
+{
+    uint32_t inc = (control >> 26) & 3;
+
+    return inc == 3 ? 0 : 1u << inc;
+}
+
+static uint32_t
+dmaDstIncrement(uint32_t control)
+{
+    uint32_t inc = (control >> 30) & 3;
+
+    return inc == 3 ? 0 : 1u << inc;
+}
+
+static hostDMAControl_t *
+dmaActive(uint32_t channel)
+/* Return the control structure a request on channel is served from, or NULL if the channel is idle. A ping-pong
+ * channel moves on to its other structure when one completes
+ */
+{
+    hostDMAControl_t *control;
+
+    if (!dmaEnabled[channel]) {
+        return 0;
+    }
+    control = &dmaControl[channel][dmaUseAlt[channel]];
+    if (control->mode == UDMA_MODE_STOP) {
+        dmaEnabled[channel] = false;
+        return 0;
+    }
+    return control;
+}
+
+static bool
+dmaComplete(uint32_t channel, hostDMAControl_t *control)
+/* Finish one item of a transfer. Returns true when the transfer is complete
+ */
+{
+    if (--control->count != 0) {
+        return false;
+    }
+    if (control->mode == UDMA_MODE_PINGPONG) {
+        dmaUseAlt[channel] = !dmaUseAlt[channel];
+    } else {
+        dmaEnabled[channel] = false;
+    }
+    control->mode = UDMA_MODE_STOP;
+    return true;
+}
+
+void
+uDMAEnable(void)
+{
+}
+
+void
+uDMAControlBaseSet(void *pControlTable)
+{
+}
+
+void
+uDMAChannelAssign(uint32_t ui32Mapping)
+{
+}
+
+void
+uDMAChannelAttributeDisable(uint32_t ui32ChannelNum, uint32_t ui32Attr)
+{
+}
+
+void
+uDMAChannelAttributeEnable(uint32_t ui32ChannelNum, uint32_t ui32Attr)
+{
+}
+
+void
+uDMAChannelControlSet(uint32_t ui32ChannelStructIndex, uint32_t ui32Control)
+{
+    dmaControl[ui32ChannelStructIndex & 0x1F][(ui32ChannelStructIndex & UDMA_ALT_SELECT) != 0].control = ui32Control;
+}
+
+void
+uDMAChannelTransferSet(uint32_t ui32ChannelStructIndex, uint32_t ui32Mode, void *pvSrcAddr, void *pvDstAddr,
+                       uint32_t ui32TransferSize)
+{
+    hostDMAControl_t *control = &dmaControl[ui32ChannelStructIndex & 0x1F][(ui32ChannelStructIndex & UDMA_ALT_SELECT) != 0];
+
+    control->mode = ui32Mode;
+    control->src = pvSrcAddr;
+    control->dst = pvDstAddr;
+    control->count = ui32TransferSize;
+}
+
+static void uartTransmitDMA(void);
+
+void
+uDMAChannelEnable(uint32_t ui32ChannelNum)
+{
+    dmaEnabled[ui32ChannelNum] = true;
+    dmaUseAlt[ui32ChannelNum] = false;
+    if (ui32ChannelNum == UDMA_CHANNEL_UART0TX) {
+        uartTransmitDMA();
+    }
+}
+
+bool
+uDMAChannelIsEnabled(uint32_t ui32ChannelNum)
+{
+    return dmaEnabled[ui32ChannelNum];
+}
+
+uint32_t
+uDMAChannelModeGet(uint32_t ui32ChannelStructIndex)
+{
+    return dmaControl[ui32ChannelStructIndex & 0x1F][(ui32ChannelStructIndex & UDMA_ALT_SELECT) != 0].mode;
+}
+
+//*****************************************************************************
+// ADC0
+//*****************************************************************************
+void
+hostSetADC(uint8_t channel, uint16_t value)
+/* Set the voltage on an analogue input, in ADC counts
+ */
+{
+    adcInput[channel] = value & 0xFFF;
+}
+
+void
+hostSetADCSource(uint8_t channel, uint16_t (*source)(void))
+/* Take each conversion of an analogue input from source, in ADC counts, for inputs that are costly to keep up to
+ * date between conversions. NULL returns to the value set by hostSetADC
+ */
+{
+    adcSource[channel] = source;
+}
+
+static void
+convertSequence(uint8_t sequence)
+/* Convert step 0 of a sequence. The sample goes to the FIFO, or to the uDMA channel of the sequence when it uses uDMA,
+ * which raises the DMA interrupt at the end of each transfer. With hardware averaging the sample is the mean of that
+ * many conversions, all taken now
+ */
+{
+    hostSequence_t *seq = &sequences[sequence];
+    uint8_t input = seq->step & 0xF;
+    uint32_t sample = 0;
+    uint32_t channel = (sequence == 3) ? UDMA_CHANNEL_ADC3 : 14 + sequence;
+    hostDMAControl_t *control = seq->dma ? dmaActive(channel) : 0;
+    uint32_t n;
+
+    for (n = 0; n < adcAverage; n++) {
+        sample += adcSource[input] ? adcSource[input]() & 0xFFF : adcInput[input];
+    }
+    sample /= adcAverage;
+
+    if (control) {
+        *(uint32_t *)control->dst = sample;     //32-bit transfers only, as the firmware uses
+        control->dst += dmaDstIncrement(control->control);
+        if (dmaComplete(channel, control)) {
+            adcRawInt |= ADC_INT_DMA_SS0 << sequence;
+        }
+    } else if (seq->fifoCount < ADC_FIFO_DEPTH) {
+        seq->fifo[seq->fifoCount++] = sample;
+    }
+    if (seq->step & ADC_CTL_IE) {
+        adcRawInt |= 1u << sequence;
+    }
+    updateInterrupt(INT_ADC0SS0 + sequence);
+}
+
+void
+ADCSequenceConfigure(uint32_t ui32Base, uint32_t ui32SequenceNum, uint32_t ui32Trigger, uint32_t ui32Priority)
+{
+    sequences[ui32SequenceNum].trigger = ui32Trigger;
+}
+
+void
+ADCSequenceStepConfigure(uint32_t ui32Base, uint32_t ui32SequenceNum, uint32_t ui32Step, uint32_t ui32Config)
+{
+    if (ui32Step == 0) {
+        sequences[ui32SequenceNum].step = ui32Config;
+    }
+}
+
+void
+ADCSequenceEnable(uint32_t ui32Base, uint32_t ui32SequenceNum)
+{
+    sequences[ui32SequenceNum].enabled = true;
+}
+
+void
+ADCSequenceDisable(uint32_t ui32Base, uint32_t ui32SequenceNum)
+{
+    sequences[ui32SequenceNum].enabled = false;
+}
+
+int32_t
+ADCSequenceDataGet(uint32_t ui32Base, uint32_t ui32SequenceNum, uint32_t *pui32Buffer)
+{
+    hostSequence_t *seq = &sequences[ui32SequenceNum];
+    int32_t count = seq->fifoCount;
+    uint8_t i;
+
+    for (i = 0; i < seq->fifoCount; i++) {
+        pui32Buffer[i] = seq->fifo[i];
+    }
+    seq->fifoCount = 0;
+    return count;
+}
+
+void
+ADCProcessorTrigger(uint32_t ui32Base, uint32_t ui32SequenceNum)
+{
+    if (sequences[ui32SequenceNum].enabled && sequences[ui32SequenceNum].trigger == ADC_TRIGGER_PROCESSOR) {
+        convertSequence(ui32SequenceNum);
+        dispatchInterrupts();
+    }
+}
+
+void
+ADCIntRegister(uint32_t ui32Base, uint32_t ui32SequenceNum, void (*pfnHandler)(void))
+{
+    handlers[INT_ADC0SS0 + ui32SequenceNum] = pfnHandler;
+    IntEnable(INT_ADC0SS0 + ui32SequenceNum);
+}
+
+void
+ADCIntEnable(uint32_t ui32Base, uint32_t ui32SequenceNum)
+{
+    adcRawInt &= ~(1u << ui32SequenceNum);
+    adcIntMask |= 1u << ui32SequenceNum;
+}
+
+void
+ADCIntDisable(uint32_t ui32Base, uint32_t ui32SequenceNum)
+{
+    adcIntMask &= ~(1u << ui32SequenceNum);
+}
+
+void
+ADCIntClear(uint32_t ui32Base, uint32_t ui32SequenceNum)
+{
+    adcRawInt &= ~(1u << ui32SequenceNum);
+}
+
+void
+ADCIntEnableEx(uint32_t ui32Base, uint32_t ui32IntFlags)
+{
+    adcIntMask |= ui32IntFlags;
+}
+
+void
+ADCIntClearEx(uint32_t ui32Base, uint32_t ui32IntFlags)
+{
+    adcRawInt &= ~ui32IntFlags;
+}
+
+uint32_t
+ADCIntStatusEx(uint32_t ui32Base, bool bMasked)
+{
+    return bMasked ? adcRawInt & adcIntMask : adcRawInt;
+}
+
+void
+ADCSequenceDMAEnable(uint32_t ui32Base, uint32_t ui32SequenceNum)
+{
+    sequences[ui32SequenceNum].dma = true;
+}
+
+void
+ADCHardwareOversampleConfigure(uint32_t ui32Base, uint32_t ui32Factor)
+{
+    adcAverage = ui32Factor > 1 ? ui32Factor : 1;
+}
+
+//*****************************************************************************
+// PWM
+//*****************************************************************************
+static hostPWM_t *
+pwmModule(uint32_t base)
+{
+    return &pwm[base == PWM1_BASE];
+}
+
+static uint8_t
+pwmGen(uint32_t gen)
+{
+    return (gen >> 6) - 1;
+}
+
+static uint8_t
+pwmOut(uint32_t out)
+{
+    return pwmGen(out & ~1u) * 2 + (out & 1);
+}
+
+double
+hostGetPWMDuty(uint32_t base, uint32_t pwmOut_)
+/* Return the duty cycle of an output as a fraction, 0 while its output or generator is off
+ */
+{
+    hostPWM_t *module = pwmModule(base);
+    uint8_t out = pwmOut(pwmOut_);
+    uint8_t gen = out / 2;
+
+    if (!(module->outEnabled & (1u << out)) || !module->genEnabled[gen] || module->period[gen] == 0) {
+        return 0.0;
+    }
+    return (double)module->width[out] / module->period[gen];
+}
+
+void
+PWMGenConfigure(uint32_t ui32Base, uint32_t ui32Gen, uint32_t ui32Config)
+{
+}
+
+void
+PWMGenPeriodSet(uint32_t ui32Base, uint32_t ui32Gen, uint32_t ui32Period)
+{
+    pwmModule(ui32Base)->period[pwmGen(ui32Gen)] = ui32Period;
+}
+
+uint32_t
+PWMGenPeriodGet(uint32_t ui32Base, uint32_t ui32Gen)
+{
+    return pwmModule(ui32Base)->period[pwmGen(ui32Gen)];
+}
+
+void
+PWMGenEnable(uint32_t ui32Base, uint32_t ui32Gen)
+{
+    pwmModule(ui32Base)->genEnabled[pwmGen(ui32Gen)] = true;
+}
+
+void
+PWMPulseWidthSet(uint32_t ui32Base, uint32_t ui32PWMOut, uint32_t ui32Width)
+{
+    pwmModule(ui32Base)->width[pwmOut(ui32PWMOut)] = ui32Width;
+}
+
+uint32_t
+PWMPulseWidthGet(uint32_t ui32Base, uint32_t ui32PWMOut)
+{
+    return pwmModule(ui32Base)->width[pwmOut(ui32PWMOut)];
+}
+
+void
+PWMOutputState(uint32_t ui32Base, uint32_t ui32PWMOutBits, bool bEnable)
+{
+    if (bEnable) {
+        pwmModule(ui32Base)->outEnabled |= ui32PWMOutBits;
+    } else {
+        pwmModule(ui32Base)->outEnabled &= ~ui32PWMOutBits;
+    }
+}
+
+//*****************************************************************************
+// QEI0
+//*****************************************************************************
+void
+hostQEIMove(int32_t counts)
+/* Move the encoder by counts edges, positive for increasing yaw
+ */
+{
+    qeiPosition += counts;
+    if (qeiMaxPosition != 0xFFFFFFFF) {
+        qeiPosition %= qeiMaxPosition + 1;
+    }
+}
+
+void
+hostQEIIndex(void)
+/* Pulse the index input
+ */
+{
+    qeiRawInt |= QEI_INTINDEX;
+    updateInterrupt(INT_QEI0);
+    dispatchInterrupts();
+}
+
+void
+QEIEnable(uint32_t ui32Base)
+{
+}
+
+void
+QEIConfigure(uint32_t ui32Base, uint32_t ui32Config, uint32_t ui32MaxPosition)
+{
+    qeiMaxPosition = ui32MaxPosition;
+}
+
+uint32_t
+QEIPositionGet(uint32_t ui32Base)
+{
+    return qeiPosition;
+}
+
+void
+QEIPositionSet(uint32_t ui32Base, uint32_t ui32Position)
+{
+    qeiPosition = ui32Position;
+}
+
+void
+QEIIntRegister(uint32_t ui32Base, void (*pfnHandler)(void))
+{
+    handlers[INT_QEI0] = pfnHandler;
+    IntEnable(INT_QEI0);
+}
+
+void
+QEIIntEnable(uint32_t ui32Base, uint32_t ui32IntFlags)
+{
+    qeiIntMask |= ui32IntFlags;
+}
+
+void
+QEIIntDisable(uint32_t ui32Base, uint32_t ui32IntFlags)
+{
+    qeiIntMask &= ~ui32IntFlags;
+}
+
+void
+QEIIntClear(uint32_t ui32Base, uint32_t ui32IntFlags)
+{
+    qeiRawInt &= ~ui32IntFlags;
+}
+
+uint32_t
+QEIIntStatus(uint32_t ui32Base, bool bMasked)
+{
+    return bMasked ? qeiRawInt & qeiIntMask : qeiRawInt;
+}
+
+//*****************************************************************************
+// UART0. Transmission is instant: the Tx FIFO always has space and
+// uDMA transfers complete as soon as they are enabled, unless the host
+// stalls the transmitter, when the FIFO stays full until it is released.
+// On a paced line the Tx FIFO instead sends a byte every UART_BITS bit
+// times of the configured baud rate, and UARTCharPut() waits for space
+// in virtual time, as it spins on the part.
+//*****************************************************************************
+static bool
+uartTxSpace(void)
+{
+    return !uartTxStalled && (!uartTxPaced || uartTxCount < UART_TX_FIFO);
+}
+
+static void
+uartPut(uint8_t byte)
+{
+    if (uartTxPaced) {
+        if (uartTxCount++ == 0) {
+            uartTxNext = now + (uint64_t)CPU_CLOCK_HZ * UART_BITS / uartBaud;
+        }
+    }
+    if (!uartOutputSet) {
+        putchar(byte);
+    } else if (uartOutput) {
+        uartOutput(byte);
+    }
+}
+
+static void uartTransmitDMA(void);
+
+static void
+uartLineSent(void)
+/* A byte has gone out on a paced line. Start the next, and ask for more once the FIFO drains to its level
+ */
+{
+    uartTxCount--;
+    if (uartTxCount > 0) {
+        uartTxNext += (uint64_t)CPU_CLOCK_HZ * UART_BITS / uartBaud;
+    }
+    if (uartTxCount <= uartTxLevel) {
+        uartRawInt |= UART_INT_TX;
+    }
+    uartTransmitDMA();
+}
+
+static void
+uartTransmitDMA(void)
+{
+    hostDMAControl_t *control;
+
+    while (uartTxSpace() && (control = dmaActive(UDMA_CHANNEL_UART0TX)) != 0) {
+        uartPut(*control->src);
+        control->src += dmaSrcIncrement(control->control);
+        if (dmaComplete(UDMA_CHANNEL_UART0TX, control)) {
+            uartRawInt |= UART_INT_DMATX;
+        }
+    }
+    updateInterrupt(INT_UART0);
+}
+
+void
+hostSetUARTOutput(void (*output)(uint8_t byte))
+/* Send transmitted bytes to output instead of stdout, or discard them if output is NULL
+ */
+{
+    uartOutput = output;
+    uartOutputSet = true;
+}
+
+void
+hostUARTInput(const char *text)
+/* Queue characters as if received
+ */
+{
+    while (*text && uartRxHead - uartRxTail < UART_RX_SIZE) {
+        uartRx[uartRxHead++ % UART_RX_SIZE] = *text++;
+    }
+}
+
+void
+hostStallUARTTx(bool stalled)
+/* Hold the Tx FIFO full while stalled, as if the line were slow. On release it empties at once and asks for more:
+ * the Tx interrupt is raised, and a uDMA transfer in progress runs to completion
+ */
+{
+    uartTxStalled = stalled;
+    if (!stalled) {
+        uartRawInt |= UART_INT_TX;
+        uartTransmitDMA();
+        updateInterrupt(INT_UART0);
+        dispatchInterrupts();
+    }
+}
+
+void
+hostPaceUARTTx(bool paced)
+/* Send at the configured baud rate through the Tx FIFO rather than at once. A UARTCharPut() that waits for space
+ * advances virtual time, so only call it from within hostRun
+ */
+{
+    uartTxPaced = paced;
+}
+
+void
+UARTConfigSetExpClk(uint32_t ui32Base, uint32_t ui32UARTClk, uint32_t ui32Baud, uint32_t ui32Config)
+{
+    uartBaud = ui32Baud;
+}
+
+void
+UARTFIFOEnable(uint32_t ui32Base)
+{
+}
+
+void
+UARTFIFOLevelSet(uint32_t ui32Base, uint32_t ui32TxLevel, uint32_t ui32RxLevel)
+{
+    uartTxLevel = (UART_TX_FIFO / 8) << ui32TxLevel;
+}
+
+void
+UARTEnable(uint32_t ui32Base)
+{
+}
+
+void
+UARTCharPut(uint32_t ui32Base, unsigned char ucData)
+/* Wait for space in the Tx FIFO of a paced line, taking interrupts as they arrive
+ */
+{
+    while (uartTxPaced && uartTxCount == UART_TX_FIFO) {
+        advance(uartTxNext);
+        dispatchInterrupts();
+    }
+    uartPut(ucData);
+}
+
+bool
+UARTCharPutNonBlocking(uint32_t ui32Base, unsigned char ucData)
+{
+    if (!uartTxSpace()) {
+        return false;
+    }
+    uartPut(ucData);
+    return true;
+}
+
+int32_t
+UARTCharGetNonBlocking(uint32_t ui32Base)
+{
+    if (uartRxHead == uartRxTail) {
+        return -1;
+    }
+    return (uint8_t)uartRx[uartRxTail++ % UART_RX_SIZE];
+}
+
+bool
+UARTCharsAvail(uint32_t ui32Base)
+{
+    return uartRxHead != uartRxTail;
+}
+
+bool
+UARTSpaceAvail(uint32_t ui32Base)
+{
+    return uartTxSpace();
+}
+
+bool
+UARTBusy(uint32_t ui32Base)
+{
+    return uartTxCount > 0;
+}
+
+void
+UARTIntRegister(uint32_t ui32Base, void (*pfnHandler)(void))
+{
+    handlers[INT_UART0] = pfnHandler;
+    IntEnable(INT_UART0);
+}
+
+void
+UARTIntEnable(uint32_t ui32Base, uint32_t ui32IntFlags)
+{
+    uartIntMask |= ui32IntFlags;
+}
+
+void
+UARTIntDisable(uint32_t ui32Base, uint32_t ui32IntFlags)
+{
+    uartIntMask &= ~ui32IntFlags;
+}
+
+void
+UARTIntClear(uint32_t ui32Base, uint32_t ui32IntFlags)
+{
+    uartRawInt &= ~ui32IntFlags;
+}
+
+uint32_t
+UARTIntStatus(uint32_t ui32Base, bool bMasked)
+{
+    return bMasked ? uartRawInt & uartIntMask : uartRawInt;
+}
+
+void
+UARTTxIntModeSet(uint32_t ui32Base, uint32_t ui32Mode)
+{
+}
+
+void
+UARTDMAEnable(uint32_t ui32Base, uint32_t ui32DMAFlags)
+{
+    uartIntMask |= UART_INT_DMATX;  //The uDMA completion interrupt cannot be masked at the UART
+}
+
+void
+UARTDMADisable(uint32_t ui32Base, uint32_t ui32DMAFlags)
+{
+}
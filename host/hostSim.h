@@ -0,0 +1,80 @@
+// *******************************************************
+//
+// hostSim.h
+//
+// Simulated TM4C123 peripherals for running the unchanged firmware
+// as a Linux process. hostSim.c implements the driverlib functions
+// the firmware calls (declared in host/include) on top of a model of
+// the NVIC, SysTick, Timers 0-3, ADC0, GPIO ports A-F, PWM0/1, QEI0,
+// UART0 and the uDMA channels used by the firmware.
+//
+// Time is virtual and counted in cycles of the CPU_CLOCK_HZ core. It
+// only advances while the firmware waits in SysCtlSleep(),
+// SysCtlDelay() or, on a UART line paced by hostPaceUARTTx(),
+// UARTCharPut(), so firmware code takes no virtual time and a run
+// goes as fast as the host can execute it. Timer, SysTick and host
+// hook events are processed in time order, and interrupts are
+// dispatched to the registered handlers whenever the firmware has
+// them unmasked, lowest interrupt number first, without nesting.
+//
+// Peripheral inputs (pins, the analogue input, encoder counts,
+// received characters) are set by the host, normally from a periodic
+// hook, and raise the interrupts they would on the part.
+//
+// The firmware's globals cannot be reset, so run it once per process.
+//
+// *******************************************************
+
+#ifndef HOSTSIM_H
+#define HOSTSIM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define HOST_MAX_HOOKS 8        //Periodic host hooks
+
+typedef void (*hostHook_t)(void);
+
+//Run control
+int hostRun(int (*entry)(void), uint64_t cycles);
+
+void hostStop(void);
+
+uint64_t hostTime(void);
+
+double hostSeconds(void);
+
+void hostAddHook(hostHook_t hook, uint32_t periodCycles);
+
+//Interrupt injection
+void hostRaise(uint32_t interrupt);
+
+//Peripheral inputs
+void hostSetPin(uint32_t portBase, uint8_t pins, bool high);
+
+bool hostGetPin(uint32_t portBase, uint8_t pin);
+
+void hostSetADC(uint8_t channel, uint16_t value);
+
+void hostSetADCSource(uint8_t channel, uint16_t (*source)(void));
+
+void hostQEIMove(int32_t counts);
+
+void hostQEIIndex(void);
+
+void hostUARTInput(const char *text);
+
+void hostStallUARTTx(bool stalled);
+
+void hostPaceUARTTx(bool paced);
+
+//Peripheral outputs
+double hostGetPWMDuty(uint32_t base, uint32_t pwmOut);
+
+void hostSetUARTOutput(void (*output)(uint8_t byte));
+
+const char *hostGetDisplayLine(uint8_t line);
+
+uint32_t hostGetDisplayWrites(void);
+
+#endif /*HOSTSIM_H*/
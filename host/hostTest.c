@@ -0,0 +1,60 @@
+// *******************************************************
+//
+// hostTest.c
+//
+// Checks for the host tests.
+//
+// *******************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include "hostTest.h"
+
+#define MAX_REPORTS 20              //Failed checks reported before the rest are only counted
+
+static uint32_t     checks;
+static uint32_t     failures;
+
+bool
+checkResult(bool passed, const char *file, int line, const char *format, ...)
+/* Count a check, and report it if it failed
+ */
+{
+    va_list args;
+
+    checks++;
+    if (!passed) {
+        if (failures < MAX_REPORTS) {
+            fprintf(stderr, "%s:%d: ", file, line);
+            va_start(args, format);
+            vfprintf(stderr, format, args);
+            va_end(args);
+            fputc('\n', stderr);
+        }
+        failures++;
+    }
+    return passed;
+}
+
+uint32_t
+testRandom(uint32_t *state)
+/* Return the next value of a xorshift generator, so a test repeats exactly for a given seed. state must not be 0
+ */
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+    return *state;
+}
+
+int
+testSummary(const char *name)
+/* Print the number of checks made and failed, and return the exit status for main()
+ */
+{
+    printf("%s: %u checks, %u failed\n", name, checks, failures);
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,28 @@
+// *******************************************************
+//
+// hostTest.h
+//
+// Checks for the host tests. Each test is a program that makes its
+// checks with CHECK(), which reports a failed one on stderr with
+// its file and line, and returns testSummary() from main(), so the
+// exit status is 1 if any failed. make -C host test builds and runs
+// them all.
+//
+// *******************************************************
+
+#ifndef HOSTTEST_H
+#define HOSTTEST_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//Check that condition holds, and report it with a printf style message if not. Evaluates to condition
+#define CHECK(condition, ...) checkResult((condition), __FILE__, __LINE__, __VA_ARGS__)
+
+bool checkResult(bool passed, const char *file, int line, const char *format, ...);
+
+uint32_t testRandom(uint32_t *state);
+
+int testSummary(const char *name);
+
+#endif /*HOSTTEST_H*/
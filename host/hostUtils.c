@@ -0,0 +1,87 @@
+// *******************************************************
+//
+// hostUtils.c
+//
+// Host build versions of the TivaWare utils/ustdlib string functions
+// and the Orbit OLED interface. The display is kept as text, read
+// back with hostGetDisplayLine(), and the characters drawn on it are
+// counted, read back with hostGetDisplayWrites().
+//
+// *******************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include "utils/ustdlib.h"
+#include "OrbitOLED/OrbitOLEDInterface.h"
+#include "hostSim.h"
+
+#define OLED_COLUMNS 16
+#define OLED_ROWS 4
+
+static char oledText[OLED_ROWS][OLED_COLUMNS + 1];
+static uint32_t oledWrites;
+
+int
+usprintf(char *pcBuf, const char *pcString, ...)
+{
+    va_list args;
+    int length;
+
+    va_start(args, pcString);
+    length = vsprintf(pcBuf, pcString, args);
+    va_end(args);
+    return length;
+}
+
+int
+usnprintf(char *pcBuf, uint32_t ui32Size, const char *pcString, ...)
+{
+    va_list args;
+    int length;
+
+    va_start(args, pcString);
+    length = vsnprintf(pcBuf, ui32Size, pcString, args);
+    va_end(args);
+    return length;
+}
+
+void
+OLEDInitialise(void)
+{
+    uint8_t row;
+
+    for (row = 0; row < OLED_ROWS; row++) {
+        memset(oledText[row], ' ', OLED_COLUMNS);
+        oledText[row][OLED_COLUMNS] = '\0';
+    }
+}
+
+void
+OLEDStringDraw(char *pcStr, uint32_t ulColumn, uint32_t ulRow)
+/* Draw a string from a character position, clipped at the right hand edge
+ */
+{
+    if (ulRow >= OLED_ROWS) {
+        return;
+    }
+    while (*pcStr && ulColumn < OLED_COLUMNS) {
+        oledText[ulRow][ulColumn++] = *pcStr++;
+        oledWrites++;
+    }
+}
+
+const char *
+hostGetDisplayLine(uint8_t line)
+{
+    return oledText[line % OLED_ROWS];
+}
+
+uint32_t
+hostGetDisplayWrites(void)
+/* Characters drawn on the display so far. Each is one glyph sent to the OLED
+ */
+{
+    return oledWrites;
+}
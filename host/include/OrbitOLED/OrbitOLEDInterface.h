@@ -0,0 +1,7 @@
+// Host build stand-in for the Orbit OLED interface. Implemented by host/hostUtils.c.
+#ifndef ORBITOLEDINTERFACE_H_
+#define ORBITOLEDINTERFACE_H_
+#include <stdint.h>
+void OLEDInitialise (void);
+void OLEDStringDraw (char *pcStr, uint32_t ulColumn, uint32_t ulRow);
+#endif
@@ -0,0 +1,13 @@
+// Host build stand-in for TivaWare driverlib/interrupt.h: declares only what the firmware uses.
+// Implemented by host/hostSim.c.
+#ifndef __DRIVERLIB_INTERRUPT_H__
+#define __DRIVERLIB_INTERRUPT_H__
+#include <stdint.h>
+#include <stdbool.h>
+extern bool IntMasterEnable(void);
+extern bool IntMasterDisable(void);
+extern void IntRegister(uint32_t ui32Interrupt, void (*pfnHandler)(void));
+extern void IntEnable(uint32_t ui32Interrupt);
+extern void IntDisable(uint32_t ui32Interrupt);
+extern void IntPrioritySet(uint32_t ui32Interrupt, uint8_t ui8Priority);
+#endif
@@ -0,0 +1,11 @@
+// Host build stand-in for TivaWare driverlib/pin_map.h: declares only what the firmware uses.
+#ifndef __DRIVERLIB_PIN_MAP_H__
+#define __DRIVERLIB_PIN_MAP_H__
+#define GPIO_PA0_U0RX           0x00000001
+#define GPIO_PA1_U0TX           0x00000401
+#define GPIO_PC5_M0PWM7         0x00021404
+#define GPIO_PF1_M1PWM5         0x00050405
+#define GPIO_PD3_IDX0           0x00030C06
+#define GPIO_PD6_PHA0           0x00031806
+#define GPIO_PD7_PHB0           0x00031C06
+#endif
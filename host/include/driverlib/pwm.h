@@ -0,0 +1,30 @@
+// Host build stand-in for TivaWare driverlib/pwm.h: declares only what the firmware uses.
+// Implemented by host/hostSim.c.
+#ifndef __DRIVERLIB_PWM_H__
+#define __DRIVERLIB_PWM_H__
+#include <stdint.h>
+#include <stdbool.h>
+#define PWM_GEN_MODE_DOWN 0x00000000
+#define PWM_GEN_MODE_UP_DOWN 0x00000002
+#define PWM_GEN_MODE_SYNC 0x00000038
+#define PWM_GEN_MODE_NO_SYNC 0x00000000
+#define PWM_GEN_MODE_GEN_NO_SYNC 0x00000000
+#define PWM_GEN_MODE_GEN_SYNC_LOCAL 0x00000280
+#define PWM_GEN_MODE_GEN_SYNC_GLOBAL 0x000003C0
+#define PWM_GEN_MODE_DBG_RUN 0x00000004
+#define PWM_GEN_0 0x00000040
+#define PWM_GEN_1 0x00000080
+#define PWM_GEN_2 0x000000C0
+#define PWM_GEN_3 0x00000100
+#define PWM_OUT_5 0x000000C1
+#define PWM_OUT_7 0x00000101
+#define PWM_OUT_5_BIT 0x00000020
+#define PWM_OUT_7_BIT 0x00000080
+extern void PWMGenConfigure(uint32_t ui32Base, uint32_t ui32Gen, uint32_t ui32Config);
+extern void PWMGenPeriodSet(uint32_t ui32Base, uint32_t ui32Gen, uint32_t ui32Period);
+extern uint32_t PWMGenPeriodGet(uint32_t ui32Base, uint32_t ui32Gen);
+extern void PWMGenEnable(uint32_t ui32Base, uint32_t ui32Gen);
+extern void PWMPulseWidthSet(uint32_t ui32Base, uint32_t ui32PWMOut, uint32_t ui32Width);
+extern uint32_t PWMPulseWidthGet(uint32_t ui32Base, uint32_t ui32PWMOut);
+extern void PWMOutputState(uint32_t ui32Base, uint32_t ui32PWMOutBits, bool bEnable);
+#endif
@@ -0,0 +1,32 @@
+// Host build stand-in for TivaWare driverlib/qei.h: declares only what the firmware uses.
+// Implemented by host/hostSim.c.
+#ifndef __DRIVERLIB_QEI_H__
+#define __DRIVERLIB_QEI_H__
+#include <stdint.h>
+#include <stdbool.h>
+#define QEI_CONFIG_CAPTURE_A_B 0x00000008
+#define QEI_CONFIG_NO_RESET 0x00000000
+#define QEI_CONFIG_RESET_IDX 0x00000010
+#define QEI_CONFIG_QUADRATURE 0x00000000
+#define QEI_CONFIG_NO_SWAP 0x00000000
+#define QEI_CONFIG_SWAP 0x00000002
+#define QEI_VELDIV_1 0x00000000
+#define QEI_INTERROR 0x00000008
+#define QEI_INTDIR 0x00000004
+#define QEI_INTTIMER 0x00000002
+#define QEI_INTINDEX 0x00000001
+extern void QEIEnable(uint32_t ui32Base);
+extern void QEIConfigure(uint32_t ui32Base, uint32_t ui32Config, uint32_t ui32MaxPosition);
+extern uint32_t QEIPositionGet(uint32_t ui32Base);
+extern void QEIPositionSet(uint32_t ui32Base, uint32_t ui32Position);
+extern int32_t QEIDirectionGet(uint32_t ui32Base);
+extern bool QEIErrorGet(uint32_t ui32Base);
+extern void QEIVelocityEnable(uint32_t ui32Base);
+extern void QEIVelocityConfigure(uint32_t ui32Base, uint32_t ui32PreDiv, uint32_t ui32Period);
+extern uint32_t QEIVelocityGet(uint32_t ui32Base);
+extern void QEIIntRegister(uint32_t ui32Base, void (*pfnHandler)(void));
+extern void QEIIntEnable(uint32_t ui32Base, uint32_t ui32IntFlags);
+extern void QEIIntDisable(uint32_t ui32Base, uint32_t ui32IntFlags);
+extern void QEIIntClear(uint32_t ui32Base, uint32_t ui32IntFlags);
+extern uint32_t QEIIntStatus(uint32_t ui32Base, bool bMasked);
+#endif
@@ -0,0 +1,23 @@
+// Host build stand-in for TivaWare driverlib/timer.h: declares only what the firmware uses.
+// Implemented by host/hostSim.c.
+#ifndef __DRIVERLIB_TIMER_H__
+#define __DRIVERLIB_TIMER_H__
+#include <stdint.h>
+#include <stdbool.h>
+#define TIMER_CFG_PERIODIC 0x00000022
+#define TIMER_CFG_PERIODIC_UP 0x00000032
+#define TIMER_A 0x000000FF
+#define TIMER_B 0x0000FF00
+#define TIMER_TIMA_TIMEOUT 0x00000001
+#define TIMER_ADC 0x00000001
+extern void TimerConfigure(uint32_t ui32Base, uint32_t ui32Config);
+extern void TimerLoadSet(uint32_t ui32Base, uint32_t ui32Timer, uint32_t ui32Value);
+extern uint32_t TimerValueGet(uint32_t ui32Base, uint32_t ui32Timer);
+extern void TimerEnable(uint32_t ui32Base, uint32_t ui32Timer);
+extern void TimerDisable(uint32_t ui32Base, uint32_t ui32Timer);
+extern void TimerControlTrigger(uint32_t ui32Base, uint32_t ui32Timer, bool bEnable);
+extern void TimerADCEventSet(uint32_t ui32Base, uint32_t ui32ADCEvent);
+extern void TimerIntRegister(uint32_t ui32Base, uint32_t ui32Timer, void (*pfnHandler)(void));
+extern void TimerIntEnable(uint32_t ui32Base, uint32_t ui32IntFlags);
+extern void TimerIntClear(uint32_t ui32Base, uint32_t ui32IntFlags);
+#endif
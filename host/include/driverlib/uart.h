@@ -0,0 +1,40 @@
+// Host build stand-in for TivaWare driverlib/uart.h: declares only what the firmware uses.
+// Implemented by host/hostSim.c.
+#ifndef __DRIVERLIB_UART_H__
+#define __DRIVERLIB_UART_H__
+#include <stdint.h>
+#include <stdbool.h>
+#define UART_CONFIG_WLEN_8 0x00000060
+#define UART_CONFIG_STOP_ONE 0x00000000
+#define UART_CONFIG_PAR_NONE 0x00000000
+#define UART_INT_DMATX 0x20000
+#define UART_INT_TX 0x020
+#define UART_INT_RX 0x010
+#define UART_INT_RT 0x040
+#define UART_TXINT_MODE_FIFO 0x00000000
+#define UART_TXINT_MODE_EOT 0x00000010
+#define UART_FIFO_TX1_8 0x00000000
+#define UART_FIFO_TX2_8 0x00000001
+#define UART_FIFO_TX4_8 0x00000002
+#define UART_FIFO_RX1_8 0x00000000
+#define UART_FIFO_RX4_8 0x00000010
+#define UART_DMA_TX 0x00000002
+extern void UARTConfigSetExpClk(uint32_t ui32Base, uint32_t ui32UARTClk, uint32_t ui32Baud, uint32_t ui32Config);
+extern void UARTFIFOEnable(uint32_t ui32Base);
+extern void UARTFIFOLevelSet(uint32_t ui32Base, uint32_t ui32TxLevel, uint32_t ui32RxLevel);
+extern void UARTEnable(uint32_t ui32Base);
+extern void UARTCharPut(uint32_t ui32Base, unsigned char ucData);
+extern bool UARTCharPutNonBlocking(uint32_t ui32Base, unsigned char ucData);
+extern int32_t UARTCharGetNonBlocking(uint32_t ui32Base);
+extern bool UARTCharsAvail(uint32_t ui32Base);
+extern bool UARTSpaceAvail(uint32_t ui32Base);
+extern bool UARTBusy(uint32_t ui32Base);
+extern void UARTIntRegister(uint32_t ui32Base, void (*pfnHandler)(void));
+extern void UARTIntEnable(uint32_t ui32Base, uint32_t ui32IntFlags);
+extern void UARTIntDisable(uint32_t ui32Base, uint32_t ui32IntFlags);
+extern void UARTIntClear(uint32_t ui32Base, uint32_t ui32IntFlags);
+extern uint32_t UARTIntStatus(uint32_t ui32Base, bool bMasked);
+extern void UARTTxIntModeSet(uint32_t ui32Base, uint32_t ui32Mode);
+extern void UARTDMAEnable(uint32_t ui32Base, uint32_t ui32DMAFlags);
+extern void UARTDMADisable(uint32_t ui32Base, uint32_t ui32DMAFlags);
+#endif
@@ -0,0 +1,6 @@
+// Host build stand-in for TivaWare inc/hw_adc.h: declares only what the firmware uses.
+#ifndef __HW_ADC_H__
+#define __HW_ADC_H__
+#define ADC_O_SSFIFO0 0x00000048
+#define ADC_O_SSFIFO3 0x000000A8
+#endif
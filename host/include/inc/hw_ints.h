@@ -0,0 +1,21 @@
+// Host build stand-in for TivaWare inc/hw_ints.h: declares only what the firmware uses.
+#ifndef __HW_INTS_H__
+#define __HW_INTS_H__
+#define FAULT_SYSTICK 15
+#define INT_GPIOA 16
+#define INT_GPIOB 17
+#define INT_GPIOC 18
+#define INT_GPIOD 19
+#define INT_GPIOE 20
+#define INT_UART0 21
+#define INT_ADC0SS0 30
+#define INT_ADC0SS1 31
+#define INT_ADC0SS2 32
+#define INT_ADC0SS3 33
+#define INT_TIMER0A 35
+#define INT_TIMER1A 37
+#define INT_TIMER2A 39
+#define INT_TIMER3A 51
+#define INT_GPIOF 46
+#define INT_QEI0 29
+#endif
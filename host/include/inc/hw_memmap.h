@@ -0,0 +1,23 @@
+// Host build stand-in for TivaWare inc/hw_memmap.h: declares only what the firmware uses.
+#ifndef __HW_MEMMAP_H__
+#define __HW_MEMMAP_H__
+#define GPIO_PORTA_BASE         0x40004000
+#define GPIO_PORTB_BASE         0x40005000
+#define GPIO_PORTC_BASE         0x40006000
+#define GPIO_PORTD_BASE         0x40007000
+#define UART0_BASE              0x4000C000
+#define GPIO_PORTE_BASE         0x40024000
+#define GPIO_PORTF_BASE         0x40025000
+#define PWM0_BASE               0x40028000
+#define PWM1_BASE               0x40029000
+#define QEI0_BASE               0x4002C000
+#define QEI1_BASE               0x4002D000
+#define TIMER0_BASE             0x40030000
+#define TIMER1_BASE             0x40031000
+#define TIMER2_BASE             0x40032000
+#define TIMER3_BASE             0x40033000
+#define WTIMER0_BASE            0x40036000
+#define ADC0_BASE               0x40038000
+#define ADC1_BASE               0x40039000
+#define UDMA_BASE               0x400FF000
+#endif
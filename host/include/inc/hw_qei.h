@@ -0,0 +1,6 @@
+// Host build stand-in for TivaWare inc/hw_qei.h: declares only what the firmware uses.
+#ifndef __HW_QEI_H__
+#define __HW_QEI_H__
+#define QEI_O_CTL 0x00000000
+#define QEI_CTL_INVI 0x00000400
+#endif
@@ -0,0 +1,9 @@
+// Host build stand-in for TivaWare inc/hw_types.h: declares only what the firmware uses.
+// Register accesses go to a sparse map of simulated registers in host/hostSim.c.
+#ifndef __HW_TYPES_H__
+#define __HW_TYPES_H__
+#include <stdint.h>
+#include <stdbool.h>
+extern volatile uint32_t *hostReg(uint32_t ui32Addr);
+#define HWREG(x) (*hostReg((uint32_t)(x)))
+#endif
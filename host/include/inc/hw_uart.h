@@ -0,0 +1,5 @@
+// Host build stand-in for TivaWare inc/hw_uart.h: declares only what the firmware uses.
+#ifndef __HW_UART_H__
+#define __HW_UART_H__
+#define UART_O_DR 0x00000000
+#endif
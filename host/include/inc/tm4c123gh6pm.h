@@ -0,0 +1,11 @@
+// Host build stand-in for TivaWare inc/tm4c123gh6pm.h: declares only what the firmware uses.
+#ifndef __TM4C123GH6PM_H__
+#define __TM4C123GH6PM_H__
+#include "inc/hw_types.h"
+#define GPIO_PORTF_LOCK_R HWREG(0x40025520)
+#define GPIO_PORTF_CR_R HWREG(0x40025524)
+#define GPIO_PORTD_LOCK_R HWREG(0x40007520)
+#define GPIO_PORTD_CR_R HWREG(0x40007524)
+#define GPIO_LOCK_KEY 0x4C4F434B
+#define GPIO_LOCK_M 0xFFFFFFFF
+#endif
@@ -0,0 +1,9 @@
+// Host build stand-in for TivaWare utils/ustdlib.h: declares only what the firmware uses.
+// Implemented by host/hostUtils.c.
+#ifndef __USTDLIB_H__
+#define __USTDLIB_H__
+#include <stdarg.h>
+#include <stdint.h>
+extern int usprintf(char *pcBuf, const char *pcString, ...);
+extern int usnprintf(char *pcBuf, uint32_t ui32Size, const char *pcString, ...);
+#endif
@@ -0,0 +1,59 @@
+// *******************************************************
+//
+// stepMetrics.c
+//
+// Step response measures for the host tools.
+//
+// *******************************************************
+
+#include <stdint.h>
+#include <math.h>
+#include "stepMetrics.h"
+
+void
+measureStep(const float *value, const float *duty, uint32_t count, double sampleRate, double target,
+            double minBand, stepMetrics_t *metrics)
+/* Measure the response in value[0..count) to a step in its target at value[0], with duty the output driving it.
+ * The settling band is SETTLE_FRACTION of the step, or minBand if that is wider
+ */
+{
+    double start = value[0];
+    double step = target - start;
+    double direction = step < 0.0 ? -1.0 : 1.0;
+    double band = fabs(step) * SETTLE_FRACTION;
+    double window = count / sampleRate;
+    double past = 0.0;
+    double dutyChange = 0.0;
+    double steadySum = 0.0;
+    uint32_t steadyStart = count > STEADY_WINDOW_S * sampleRate ? count - (uint32_t)(STEADY_WINDOW_S * sampleRate) : 0;
+    uint32_t risen = count;
+    uint32_t settled = 0;
+    uint32_t i;
+
+    if (band < minBand) {
+        band = minBand;
+    }
+    for (i = 0; i < count; i++) {
+        if (risen == count && (value[i] - start) * direction >= 0.9 * fabs(step)) {
+            risen = i;
+        }
+        if ((value[i] - target) * direction > past) {
+            past = (value[i] - target) * direction;
+        }
+        if (fabs(value[i] - target) > band) {
+            settled = i + 1;
+        }
+        if (i >= steadyStart) {
+            steadySum += value[i];
+        }
+        if (i > 0) {
+            dutyChange += fabs(duty[i] - duty[i - 1]);
+        }
+    }
+
+    metrics->riseTime = risen / sampleRate;
+    metrics->overshoot = step != 0.0 ? past / fabs(step) * 100.0 : 0.0;
+    metrics->settlingTime = settled / sampleRate;
+    metrics->steadyError = count > 0 ? fabs(steadySum / (count - steadyStart) - target) : 0.0;
+    metrics->effort = window > 0.0 ? dutyChange / window : 0.0;
+}
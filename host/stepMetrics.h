@@ -0,0 +1,39 @@
+// *******************************************************
+//
+// stepMetrics.h
+//
+// Step response measures for the host tools, from a rig quantity
+// and the duty cycle driving it sampled at a fixed rate from the time
+// of a step in its target.
+//
+//  - Rise time: to 90% of the step. The window length if never.
+//  - Overshoot: furthest past the target, as a percentage of the step.
+//  - Settling time: to staying within the settling band of the
+//    target. The window length if outside it at the end.
+//  - Steady state error: of the mean over the last STEADY_WINDOW_S
+//    of the window from the target, either way.
+//  - Effort: the total change in duty per second, in % per second.
+//    Lower is gentler on the rotors; a noisy controller scores high.
+//
+// *******************************************************
+
+#ifndef STEPMETRICS_H
+#define STEPMETRICS_H
+
+#include <stdint.h>
+
+#define SETTLE_FRACTION 0.05        //Settling band as a fraction of the step, unless narrower than the minimum
+#define STEADY_WINDOW_S 1.0         //End of the window averaged for the steady state error
+
+typedef struct {
+    double riseTime;                //Seconds
+    double overshoot;               //Percent of the step
+    double settlingTime;            //Seconds
+    double steadyError;             //Units of the quantity
+    double effort;                  //Duty % per second
+} stepMetrics_t;
+
+void measureStep(const float *value, const float *duty, uint32_t count, double sampleRate, double target,
+                 double minBand, stepMetrics_t *metrics);
+
+#endif /*STEPMETRICS_H*/
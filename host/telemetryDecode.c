@@ -0,0 +1,66 @@
+// *******************************************************
+//
+// telemetryDecode.c
+//
+// Linux command line decoder for the binary telemetry stream sent
+// when the firmware is built with TELEMETRY_BINARY. Reads the raw
+// serial stream from a file or stdin and writes one CSV row per
+// valid frame to stdout. Frames that fail COBS decoding or their
+// CRC are counted and reported on stderr.
+//
+// Build: gcc -O2 -I.. -o telemetryDecode telemetryDecode.c ../telemetry.c
+// Use:   stty -F /dev/ttyACM0 115200 raw && ./telemetryDecode /dev/ttyACM0 > flight.csv
+//        with the firmware built with -DBAUD_RATE=115200
+//
+// *******************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include "telemetry.h"
+
+int
+main(int argc, char *argv[])
+{
+    FILE *in = stdin;
+    uint8_t frame[TELEMETRY_FRAME_MAX];
+    uint16_t length = 0;
+    bool overrun = false;
+    unsigned long good = 0;
+    unsigned long bad = 0;
+    telemetry_t sample;
+    int c;
+
+    if (argc > 1 && (in = fopen(argv[1], "rb")) == NULL) {
+        perror(argv[1]);
+        return 1;
+    }
+
+    printf("time_ms,height,target_height,yaw,target_yaw,duty_main,duty_tail,flight_mode\n");
+    while ((c = fgetc(in)) != EOF) {
+        if (c != 0) {
+            //Anything longer than a frame is line noise; skip to the next delimiter
+            if (length < sizeof(frame)) {
+                frame[length++] = c;
+            } else {
+                overrun = true;
+            }
+            continue;
+        }
+        if (length > 0) {
+            if (!overrun && telemetryDecode(frame, length, &sample)) {
+                printf("%lu,%u,%u,%d,%d,%.2f,%.2f,%u\n", (unsigned long)sample.timeMs,
+                       sample.height, sample.targetHeight, sample.yaw, sample.targetYaw,
+                       sample.dutyMain / 100.0, sample.dutyTail / 100.0, sample.flightMode);
+                good++;
+            } else {
+                bad++;
+            }
+            fflush(stdout);
+        }
+        length = 0;
+        overrun = false;
+    }
+    fprintf(stderr, "%lu frames decoded, %lu rejected\n", good, bad);
+    return 0;
+}
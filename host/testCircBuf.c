@@ -0,0 +1,165 @@
+// *******************************************************
+//
+// testCircBuf.c
+//
+// Test of the circBufT running sum. For every window size up to
+// MAX_SIZE, and so storage capacities of 2 to 256 entries, it makes a
+// pseudo-random sequence of single and block writes and reads, and
+// after each checks the running sum and meanCircBuf() against the sum
+// of the last size entries worked out in full. It also checks that
+// reads return the entries written, in order. First, CIRCBUF_CAPACITY
+// must give the smallest power of two above each size, over all sizes
+// up to 2^20 and either side of every larger power of two, and
+// initCircBuf() must refuse a window of no entries.
+//
+// Build: make -C host test
+// Use:   host/testCircBuf
+//        make -C host FIRMWARE_FLAGS=-DCIRCBUF_ENTRY_16 test
+//
+// *******************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "circBufT.h"
+#include "hostTest.h"
+
+#define TEST_OPERATIONS 20000       //Writes and reads per window size
+#define MAX_SIZE 130                //Window sizes tested, 1 to MAX_SIZE
+#define MAX_BLOCK (2 * MAX_SIZE)    //Longest block write, to overwrite the whole window at once
+#define MAX_ENTRY 0xFFF             //12 bit samples, so the test holds with CIRCBUF_ENTRY_16
+#define CAPACITY_SIZES (1 << 20)    //Sizes whose capacity is checked one by one
+
+CIRCBUF_STORAGE(storage, MAX_SIZE);
+
+//Every entry written, in order
+static uint32_t     written[TEST_OPERATIONS * MAX_BLOCK];
+
+static uint32_t
+fullSum(uint32_t count, uint32_t size)
+/* Return the sum of the last size of count entries written, counting the cleared storage as zeros
+ */
+{
+    uint32_t sum = 0;
+    uint32_t i;
+
+    for (i = count > size ? count - size : 0; i < count; i++) {
+        sum += written[i];
+    }
+    return sum;
+}
+
+static void
+testSize(uint32_t size, bool heap, uint32_t *seed)
+{
+    circBuf_t buffer;
+    uint32_t block[MAX_BLOCK];
+    uint32_t count = 0;
+    uint32_t consumed = 0;
+    uint32_t operation;
+    uint32_t choice;
+    uint32_t length;
+    uint32_t sum;
+    uint32_t entry;
+    uint32_t i;
+
+    if (heap) {
+        CHECK(initCircBuf(&buffer, size) != NULL, "size %u: initCircBuf failed", size);
+    } else {
+        initCircBufStatic(&buffer, size, storage);
+    }
+    CHECK(buffer.mask + 1 == CIRCBUF_CAPACITY(size) && buffer.mask + 1 > size,
+          "size %u: capacity %u", size, buffer.mask + 1);
+    for (operation = 0; operation < TEST_OPERATIONS; operation++) {
+        choice = testRandom(seed) % 10;
+        if (choice < 5) {
+            written[count] = testRandom(seed) & MAX_ENTRY;
+            writeCircBuf(&buffer, written[count++]);
+        } else if (choice < 6) {
+            length = testRandom(seed) % (MAX_BLOCK + 1);
+            for (i = 0; i < length; i++) {
+                block[i] = written[count + i] = testRandom(seed) & MAX_ENTRY;
+            }
+            writeCircBufN(&buffer, block, length);
+            count += length;
+        } else if (choice < 9) {
+            if (circBufCount(&buffer) > 0) {
+                if (count - consumed > buffer.mask + 1) {
+                    consumed = count - (buffer.mask + 1); //Overwritten before being read
+                    buffer.rindex = consumed;
+                }
+                entry = readCircBuf(&buffer);
+                CHECK(entry == written[consumed], "size %u: read %u of entry %u, written %u", size, entry, consumed,
+                      written[consumed]);
+                consumed++;
+            }
+        } else {
+            length = testRandom(seed) % (size + 2);
+            i = readCircBufN(&buffer, block, length);
+            length = length < size ? length : size;
+            length = length < count ? length : count;
+            CHECK(i == length, "size %u: readCircBufN gave %u entries, expected %u", size, i, length);
+            for (i = 0; i < length; i++) {
+                CHECK(block[i] == written[count - length + i], "size %u: readCircBufN entry %u is %u, written %u",
+                      size, i, block[i], written[count - length + i]);
+            }
+            consumed = count;
+        }
+        sum = fullSum(count, size);
+        CHECK(buffer.sum == sum, "size %u: running sum %u after %u entries, full sum %u", size, buffer.sum, count,
+              sum);
+        CHECK(meanCircBuf(&buffer) == (2 * sum + size) / (2 * size), "size %u: mean %u, full sum %u", size,
+              meanCircBuf(&buffer), sum);
+    }
+    freeCircBuf(&buffer);
+}
+
+static bool
+checkCapacity(uint32_t size)
+/* Check that the capacity for size is the smallest power of two above it
+ */
+{
+    uint32_t capacity = CIRCBUF_CAPACITY(size);
+
+    return CHECK((capacity & (capacity - 1)) == 0 && capacity > size && capacity / 2 <= size,
+                 "size %u: capacity %u is not the next power of two above it", size, capacity);
+}
+
+static void
+testCapacity(void)
+/* Every size up to CAPACITY_SIZES, then either side of each larger power of two up to the largest a capacity holds
+ */
+{
+    uint32_t size;
+    uint8_t bit;
+
+    for (size = 1; size <= CAPACITY_SIZES; size++) {
+        if (!checkCapacity(size)) {
+            return;
+        }
+    }
+    for (bit = 21; bit < 31; bit++) {
+        checkCapacity((1u << bit) - 1);
+        checkCapacity(1u << bit);
+        checkCapacity((1u << bit) + 1);
+    }
+    checkCapacity((1u << 31) - 1);
+}
+
+int
+main(void)
+{
+    circBuf_t empty;
+    uint32_t seed = 1;
+    uint32_t size;
+
+    testCapacity();
+    CHECK(initCircBuf(&empty, 0) == NULL, "size 0: initCircBuf gave storage for a window of no entries");
+    freeCircBuf(&empty);
+    for (size = 1; size <= MAX_SIZE; size++) {
+        testSize(size, false, &seed);
+        testSize(size, true, &seed);
+    }
+    return testSummary("testCircBuf");
+}
@@ -0,0 +1,137 @@
+// *******************************************************
+//
+// testCircBufThreads.c
+//
+// Stress test of circBufT as a single-producer/single-consumer ring,
+// with a producer and a consumer thread writing and reading one
+// buffer at once, as an ISR and the main loop do on the target.
+// Entries are sequence numbers, so a lost, repeated or torn entry
+// shows as a break in the sequence.
+//
+//  - In order: the producer waits while the ring is full, and the
+//    consumer reads single entries with readCircBuf(). Every number
+//    must arrive once, in order.
+//  - Latest block: the producer never waits, and the consumer takes
+//    the latest entries with readCircBufN() while they are being
+//    overwritten, relying on its retry loop. Every block must be
+//    consecutive numbers, and no later than the one before.
+//
+// Build: make -C host test
+// Use:   host/testCircBufThreads
+//
+// *******************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <sched.h>
+#include "circBufT.h"
+#include "hostTest.h"
+
+#define TEST_SIZE 50                //Window size, storage of 64 entries as for the height buffer
+#define IN_ORDER_ENTRIES 2000000
+#define BLOCK_ENTRIES 20000000      //Entries written while the consumer takes blocks
+#define BLOCK_LENGTH 40             //Entries per readCircBufN(), leaving the writer little room
+
+//Entries as stored, so the test holds with CIRCBUF_ENTRY_16
+#define ENTRY(sequence) ((circBufEntry_t)(sequence))
+
+CIRCBUF_STORAGE(storage, TEST_SIZE);
+
+static circBuf_t    buffer;
+static volatile bool inOrder;
+static volatile bool producing;
+
+static void *
+producer(void *unused)
+{
+    uint32_t sequence;
+
+    for (sequence = 0; sequence < (inOrder ? IN_ORDER_ENTRIES : BLOCK_ENTRIES); sequence++) {
+        while (inOrder && buffer.windex - buffer.rindex > buffer.mask) {
+            sched_yield(); //Full: wait for the consumer
+        }
+        writeCircBuf(&buffer, sequence);
+    }
+    producing = false;
+    return NULL;
+}
+
+static void
+testInOrder(void)
+{
+    pthread_t thread;
+    uint32_t expected = 0;
+    uint32_t entry;
+
+    initCircBufStatic(&buffer, TEST_SIZE, storage);
+    inOrder = true;
+    producing = true;
+    pthread_create(&thread, NULL, producer, NULL);
+    while (expected < IN_ORDER_ENTRIES) {
+        if (circBufCount(&buffer) == 0) {
+            sched_yield();
+            continue;
+        }
+        entry = readCircBuf(&buffer);
+        if (!CHECK(entry == ENTRY(expected), "in order: read %u, expected %u", entry, ENTRY(expected))) {
+            break;
+        }
+        expected++;
+    }
+    pthread_join(thread, NULL);
+    CHECK(circBufCount(&buffer) == 0, "in order: %u entries left over", circBufCount(&buffer));
+}
+
+static void
+testLatestBlock(void)
+{
+    pthread_t thread;
+    uint32_t block[BLOCK_LENGTH];
+    uint32_t length;
+    uint32_t blocks = 0;
+    uint32_t last = 0;
+    uint32_t end;
+    uint32_t i;
+    bool consecutive;
+
+    initCircBufStatic(&buffer, TEST_SIZE, storage);
+    inOrder = false;
+    producing = true;
+    pthread_create(&thread, NULL, producer, NULL);
+    while (producing) {
+        length = readCircBufN(&buffer, block, BLOCK_LENGTH);
+        if (length < BLOCK_LENGTH) {
+            continue; //Too few written yet
+        }
+        consecutive = true;
+        for (i = 1; i < length; i++) {
+            consecutive = consecutive && block[i] == ENTRY(block[i - 1] + 1);
+        }
+        CHECK(consecutive, "latest block: block %u from %u is not consecutive", blocks, block[0]);
+        //The writer can run on by more than a 16 bit entry holds between blocks, so the block's place in the
+        //sequence is taken from rindex, which readCircBufN leaves just after it, and the entry checked against that
+        end = buffer.rindex - 1;
+        CHECK(block[length - 1] == ENTRY(end), "latest block: block %u ends at %u, not %u", blocks,
+              block[length - 1], ENTRY(end));
+        CHECK(end >= last, "latest block: block %u ends at %u, before %u", blocks, end, last);
+        last = end;
+        blocks++;
+    }
+    pthread_join(thread, NULL);
+    length = readCircBufN(&buffer, block, BLOCK_LENGTH);
+    CHECK(length == BLOCK_LENGTH && buffer.rindex == BLOCK_ENTRIES && block[length - 1] == ENTRY(BLOCK_ENTRIES - 1),
+          "latest block: last block ends at %u of %u, expected %u", block[length - 1], buffer.rindex,
+          ENTRY(BLOCK_ENTRIES - 1));
+    CHECK(blocks > 0, "latest block: no blocks read while writing");
+}
+
+int
+main(void)
+{
+    testInOrder();
+    testLatestBlock();
+    return testSummary("testCircBufThreads");
+}
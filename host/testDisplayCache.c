@@ -0,0 +1,155 @@
+// *******************************************************
+//
+// testDisplayCache.c
+//
+// Test that displayCache sends the OLED only what changed. Frames of
+// four lines are drawn with displayLine() on the host OLED stub,
+// which counts the characters drawn. Each frame is a random edit of
+// the last: a few characters changed, a line cut short or left
+// alone. The display must then show what a full redraw would, and
+// exactly the characters that differ from it must have been sent, so
+// a frame that changes nothing sends nothing. Last, the firmware's
+// updateDisplay() must send nothing when its values are unchanged.
+//
+// Build: make -C host test
+// Use:   host/testDisplayCache
+//
+// *******************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "displayCache.h"
+#include "motorControl.h"
+#include "hostSim.h"
+#include "hostTest.h"
+
+#define TEST_FRAMES 20000
+#define UNCHANGED_ONE_IN 4          //Chance that a frame leaves every line as it was
+#define EDITS_MAX 3                 //Characters changed in an edited line
+
+//The firmware's OLED update
+void updateDisplay(uint16_t PWMMain, uint16_t PWMTail);
+
+//What a full redraw of every frame so far would show, and the strings of the last frame
+static char         shown[DISPLAY_LINES][DISPLAY_COLUMNS + 1];
+static char         frame[DISPLAY_LINES][DISPLAY_COLUMNS + 1];
+
+static void
+editLine(char *string, uint32_t *seed)
+/* Change a few characters of string, from a small alphabet so some edits leave it as it was, and sometimes cut it
+ * short or lengthen it to the full width
+ */
+{
+    static const char alphabet[] = " 0123456789%=-";
+    uint32_t length = strlen(string);
+    uint8_t edit;
+
+    for (edit = testRandom(seed) % (EDITS_MAX + 1); edit > 0 && length > 0; edit--) {
+        string[testRandom(seed) % length] = alphabet[testRandom(seed) % (sizeof(alphabet) - 1)];
+    }
+    switch (testRandom(seed) % 8) {
+    case 0:
+        string[testRandom(seed) % (DISPLAY_COLUMNS + 1)] = '\0';
+        break;
+    case 1:
+        memset(&string[length], '-', DISPLAY_COLUMNS - length);
+        string[DISPLAY_COLUMNS] = '\0';
+        break;
+    }
+}
+
+static uint32_t
+changedCharacters(const char *string, uint8_t line)
+/* Draw string over the model of line, returning the number of characters that differ from what was shown
+ */
+{
+    uint32_t changed = 0;
+    uint8_t column;
+
+    for (column = 0; column < DISPLAY_COLUMNS && string[column] != '\0'; column++) {
+        if (shown[line][column] != string[column]) {
+            shown[line][column] = string[column];
+            changed++;
+        }
+    }
+    return changed;
+}
+
+static void
+testFrames(void)
+/* Random frames through displayLine, each compared with a full redraw
+ */
+{
+    uint32_t seed = 1;
+    uint32_t frameNumber;
+    uint32_t expected;
+    uint32_t writes;
+    uint32_t unchangedFrames = 0;
+    uint8_t line;
+    bool unchanged;
+
+    for (line = 0; line < DISPLAY_LINES; line++) {
+        memset(shown[line], ' ', DISPLAY_COLUMNS);
+        strcpy(frame[line], "Line = 0");
+    }
+    for (frameNumber = 0; frameNumber < TEST_FRAMES; frameNumber++) {
+        unchanged = testRandom(&seed) % UNCHANGED_ONE_IN == 0;
+        expected = 0;
+        writes = hostGetDisplayWrites();
+        for (line = 0; line < DISPLAY_LINES; line++) {
+            if (!unchanged) {
+                editLine(frame[line], &seed);
+            }
+            expected += changedCharacters(frame[line], line);
+            displayLine(frame[line], line);
+        }
+        writes = hostGetDisplayWrites() - writes;
+        if (unchanged && frameNumber > 0) {
+            unchangedFrames++;
+            if (!CHECK(writes == 0, "frame %u: %u characters sent for an unchanged frame", frameNumber, writes)) {
+                break;
+            }
+        }
+        if (!CHECK(writes == expected, "frame %u: %u characters sent, not the %u changed", frameNumber, writes,
+                   expected)) {
+            break;
+        }
+        for (line = 0; line < DISPLAY_LINES; line++) {
+            if (!CHECK(strcmp(hostGetDisplayLine(line), shown[line]) == 0, "frame %u line %u: \"%s\", not \"%s\"",
+                       frameNumber, line, hostGetDisplayLine(line), shown[line])) {
+                return;
+            }
+        }
+    }
+    printf("testDisplayCache: %u frames, %u unchanged\n", frameNumber, unchangedFrames);
+}
+
+static void
+testUpdateDisplay(void)
+/* The firmware's display update sends nothing when its values are unchanged, and only the changed digits when one is
+ */
+{
+    uint32_t writes;
+
+    updateDisplay(PWM_PERCENT(50), PWM_PERCENT(20));
+    writes = hostGetDisplayWrites();
+    updateDisplay(PWM_PERCENT(50), PWM_PERCENT(20));
+    CHECK(hostGetDisplayWrites() == writes, "%u characters sent for unchanged values", hostGetDisplayWrites() - writes);
+    writes = hostGetDisplayWrites();
+    updateDisplay(PWM_PERCENT(50) + 1, PWM_PERCENT(20));
+    CHECK(hostGetDisplayWrites() - writes == 1, "%u characters sent for a one digit change",
+          hostGetDisplayWrites() - writes);
+}
+
+int
+main(void)
+{
+    initDisplay();
+    testFrames();
+    initDisplay();
+    testUpdateDisplay();
+    return testSummary("testDisplayCache");
+}
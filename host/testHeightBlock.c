@@ -0,0 +1,84 @@
+// *******************************************************
+//
+// testHeightBlock.c
+//
+// Test that the uDMA path of heliHeight, which passes samples to
+// heightSampleBlock() HEIGHT_DMA_BLOCK at a time, gives the same
+// height and rate as the interrupt per sample path, which passes
+// them one at a time. The same noisy trace of steps and ramps goes
+// through both, and the estimates are compared after every block.
+// With HEIGHT_USE_MEAN the block path gives the mean rate over the
+// block rather than the last change, so only the height is compared.
+//
+// Build: make -C host test
+// Use:   host/testHeightBlock
+//        make -C host FIRMWARE_FLAGS=-DHEIGHT_OVERSAMPLE test
+//
+// *******************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "heliHeight.h"
+#include "hostTest.h"
+
+#define TEST_BLOCKS 2000
+#define TEST_SAMPLES (TEST_BLOCKS * HEIGHT_DMA_BLOCK)
+#define LANDED_ADC 2482             //Altitude sensor on the ground
+#define NOISE_COUNTS 16             //Peak to peak sample noise
+
+static uint32_t     trace[TEST_SAMPLES];
+static uint16_t     sampleHeight[TEST_BLOCKS];
+static int32_t      sampleRate[TEST_BLOCKS];
+
+static void
+makeTrace(void)
+/* Fill trace with a rise, a hover, steps and a ramp back down, plus noise
+ */
+{
+    uint32_t seed = 1;
+    uint32_t i;
+    int32_t level;
+
+    for (i = 0; i < TEST_SAMPLES; i++) {
+        if (i < TEST_SAMPLES / 4) {
+            level = LANDED_ADC - (int32_t)(i * 400 / (TEST_SAMPLES / 4));
+        } else if (i < TEST_SAMPLES / 2) {
+            level = LANDED_ADC - 400 + ((i / 500) & 1) * 120;
+        } else {
+            level = LANDED_ADC - 400 + (int32_t)((i - TEST_SAMPLES / 2) * 400 / (TEST_SAMPLES / 2));
+        }
+        trace[i] = (uint32_t)(level + (int32_t)(testRandom(&seed) % NOISE_COUNTS) - NOISE_COUNTS / 2);
+    }
+}
+
+int
+main(void)
+{
+    uint32_t block;
+    uint32_t i;
+
+    makeTrace();
+
+    initHeightADC();
+    for (block = 0; block < TEST_BLOCKS; block++) {
+        for (i = 0; i < HEIGHT_DMA_BLOCK; i++) {
+            heightSampleBlock(&trace[block * HEIGHT_DMA_BLOCK + i], 1);
+        }
+        sampleHeight[block] = getHeightADC();
+        sampleRate[block] = getHeightRate();
+    }
+
+    initHeightADC();
+    for (block = 0; block < TEST_BLOCKS; block++) {
+        heightSampleBlock(&trace[block * HEIGHT_DMA_BLOCK], HEIGHT_DMA_BLOCK);
+        CHECK(getHeightADC() == sampleHeight[block], "block %u: height %u, per sample %u", block, getHeightADC(),
+              sampleHeight[block]);
+#ifndef HEIGHT_USE_MEAN
+        CHECK(getHeightRate() == sampleRate[block], "block %u: rate %d, per sample %d", block, getHeightRate(),
+              sampleRate[block]);
+#endif
+    }
+    return testSummary("testHeightBlock");
+}
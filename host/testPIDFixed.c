@@ -0,0 +1,184 @@
+// *******************************************************
+//
+// testPIDFixed.c
+//
+// Test that the fixed-point controllers give the same duty as the
+// double precision ones they replaced, to within the 1% that
+// PIDController.h promises. PIDController.c is built twice into this
+// test, once with PID_USE_FLOAT, with each build's functions renamed
+// with a flt_ or fix_ prefix (see the Makefile). Both are fed the
+// same inputs: every height and yaw error over its range, each
+// followed by its negation so the integrals stay bounded, then a
+// pseudo-random run of errors and rates. After every step the two
+// main and tail duties must agree to within PID_TOLERANCE. This is
+// done with the built-in gains and with gains four times larger.
+// Last, both builds are timed over the same pseudo-random errors and
+// rates, and their host nanoseconds per main and tail step reported.
+// These compare the two on the host, which has an FPU for doubles;
+// the target has none, so measure the gain there under
+// PROFILE_PID_MAIN and PROFILE_PID_TAIL.
+//
+// Build: make -C host test
+// Use:   host/testPIDFixed
+//
+// *******************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "PIDController.h"
+#include "motorControl.h"
+#include "hostClock.h"
+#include "hostTest.h"
+
+#define PID_TOLERANCE PWM_PERCENT(1)    //Largest duty difference allowed, parts per PWM_DUTY_SCALE
+#define TARGET_HEIGHT 2000              //ADC counts; errors of up to RANGE_ADC either side
+#define YAW_RANGE 360                   //Yaw errors, degrees either side of the target
+#define HEIGHT_RATE_RANGE 2000          //ADC counts per second either side of still
+#define YAW_RATE_RANGE 200              //Degrees per second either side of still
+#define RANDOM_STEPS 200000
+#define GAIN_SCALE 4                    //Multiple of the built-in gains for the second pass
+#define TIMING_STEPS 100000             //Steps in the timed sequence
+#define TIMING_PASSES 20                //Times each build runs the sequence
+
+//The two builds of PIDController.c
+uint16_t flt_PIDMainControl(uint16_t currentHeight, uint16_t targetHeight, uint16_t landedHeight, int32_t heightRate);
+uint16_t flt_PIDTailControl(int16_t targetYaw, int16_t currentYaw, int16_t yawRate);
+void flt_setPIDGains(double kp, double ki, double kd, double kpTail, double kiTail, double kdTail);
+uint16_t fix_PIDMainControl(uint16_t currentHeight, uint16_t targetHeight, uint16_t landedHeight, int32_t heightRate);
+uint16_t fix_PIDTailControl(int16_t targetYaw, int16_t currentYaw, int16_t yawRate);
+void fix_setPIDGains(double kp, double ki, double kd, double kpTail, double kiTail, double kdTail);
+
+static uint32_t     seed = 1;
+static int32_t      largestDifference;
+
+//The timed sequence: height error and rate, yaw error and rate for each step
+static int32_t      timingInputs[TIMING_STEPS][4];
+
+//The controllers set the PWM themselves. Their duty is taken from the return value instead
+void
+setPWMMain(uint32_t u32Duty)
+{
+}
+
+void
+setPWMTail(uint32_t u32Duty)
+{
+}
+
+static int32_t
+randomIn(int32_t range)
+/* A pseudo-random value from -range to range
+ */
+{
+    return (int32_t)(testRandom(&seed) % (2 * range + 1)) - range;
+}
+
+static bool
+compareStep(int32_t heightError, int32_t heightRate, int32_t yawError, int32_t yawRate)
+/* Run both builds' main and tail controllers for one step, and check that their duties agree
+ */
+{
+    uint16_t height = TARGET_HEIGHT + heightError;
+    int16_t yaw = (int16_t)yawError;
+    int32_t mainFloat = flt_PIDMainControl(height, TARGET_HEIGHT, 0, heightRate);
+    int32_t mainFixed = fix_PIDMainControl(height, TARGET_HEIGHT, 0, heightRate);
+    int32_t tailFloat = flt_PIDTailControl(0, -yaw, yawRate);
+    int32_t tailFixed = fix_PIDTailControl(0, -yaw, yawRate);
+
+    if (abs(mainFloat - mainFixed) > largestDifference) {
+        largestDifference = abs(mainFloat - mainFixed);
+    }
+    if (abs(tailFloat - tailFixed) > largestDifference) {
+        largestDifference = abs(tailFloat - tailFixed);
+    }
+    return CHECK(abs(mainFloat - mainFixed) <= PID_TOLERANCE,
+                 "height error %d, rate %d: float duty %d, fixed duty %d", heightError, heightRate, mainFloat,
+                 mainFixed)
+        && CHECK(abs(tailFloat - tailFixed) <= PID_TOLERANCE, "yaw error %d, rate %d: float duty %d, fixed duty %d",
+                 yawError, yawRate, tailFloat, tailFixed);
+}
+
+static void
+compareControllers(double gainScale)
+/* Set both builds' gains to gainScale times the built-in ones, and compare them over the error sweep and the
+ * random run. Stops at the first step that differs
+ */
+{
+    int32_t error;
+    uint32_t step;
+
+    flt_setPIDGains(KP * gainScale, KI * gainScale, KD * gainScale, KP_t * gainScale, KI_t * gainScale,
+                    KD_t * gainScale);
+    fix_setPIDGains(KP * gainScale, KI * gainScale, KD * gainScale, KP_t * gainScale, KI_t * gainScale,
+                    KD_t * gainScale);
+    for (error = -RANGE_ADC; error <= RANGE_ADC; error++) {
+        int32_t yawError = error * YAW_RANGE / RANGE_ADC;
+        int32_t heightRate = randomIn(HEIGHT_RATE_RANGE);
+        int32_t yawRate = randomIn(YAW_RATE_RANGE);
+
+        if (!compareStep(error, heightRate, yawError, yawRate)
+            || !compareStep(-error, -heightRate, -yawError, -yawRate)) {
+            return;
+        }
+    }
+    for (step = 0; step < RANDOM_STEPS; step++) {
+        if (!compareStep(randomIn(RANGE_ADC), randomIn(HEIGHT_RATE_RANGE), randomIn(YAW_RANGE),
+                         randomIn(YAW_RATE_RANGE))) {
+            return;
+        }
+    }
+}
+
+static double
+timeController(uint16_t (*mainControl)(uint16_t, uint16_t, uint16_t, int32_t),
+               uint16_t (*tailControl)(int16_t, int16_t, int16_t))
+/* Return the mean host nanoseconds for one main and one tail step of a build over the timed sequence
+ */
+{
+    uint32_t pass;
+    uint32_t step;
+    uint64_t start;
+    volatile uint16_t sink;
+
+    start = hostNanoseconds();
+    for (pass = 0; pass < TIMING_PASSES; pass++) {
+        for (step = 0; step < TIMING_STEPS; step++) {
+            sink = mainControl(TARGET_HEIGHT + timingInputs[step][0], TARGET_HEIGHT, 0, timingInputs[step][1]);
+            sink = tailControl(0, -(int16_t)timingInputs[step][2], timingInputs[step][3]);
+        }
+    }
+    (void)sink;
+    return (double)(hostNanoseconds() - start) / ((uint64_t)TIMING_STEPS * TIMING_PASSES);
+}
+
+static void
+timeControllers(void)
+/* Time both builds with the built-in gains over the same sequence of errors and rates
+ */
+{
+    uint32_t step;
+
+    for (step = 0; step < TIMING_STEPS; step++) {
+        timingInputs[step][0] = randomIn(RANGE_ADC);
+        timingInputs[step][1] = randomIn(HEIGHT_RATE_RANGE);
+        timingInputs[step][2] = randomIn(YAW_RANGE);
+        timingInputs[step][3] = randomIn(YAW_RATE_RANGE);
+    }
+    flt_setPIDGains(KP, KI, KD, KP_t, KI_t, KD_t);
+    fix_setPIDGains(KP, KI, KD, KP_t, KI_t, KD_t);
+    printf("testPIDFixed: host ns per main and tail step, float %.1f, fixed %.1f\n",
+           timeController(flt_PIDMainControl, flt_PIDTailControl),
+           timeController(fix_PIDMainControl, fix_PIDTailControl));
+}
+
+int
+main(void)
+{
+    compareControllers(1);
+    compareControllers(GAIN_SCALE);
+    printf("testPIDFixed: largest duty difference %d of %d\n", largestDifference, PWM_DUTY_SCALE);
+    timeControllers();
+    return testSummary("testPIDFixed");
+}
@@ -0,0 +1,242 @@
+// *******************************************************
+//
+// testSerialTx.c
+//
+// Test the non-blocking transmit path of serialCom on the simulated
+// UART. The host stalls the transmitter, so queued bytes wait in the
+// transmit queue as they would behind a slow line, and releases it
+// at random, when the queue drains from the UART interrupt (or by
+// uDMA with UART_TX_DMA). Sends never wait: while stalled nothing
+// reaches the line, bytes beyond UART_TX_BUF_SIZE are dropped and
+// counted, and what does arrive is what a model of the queue says
+// was accepted, in order, across many wraps of the queue. Then a
+// whole updateSerial() report must be queued without a drop. Last,
+// on a line paced at BAUD_RATE, the report is sent through the queue
+// and then by the blocking loop UARTSend() used before it, and the
+// virtual time each holds up the caller is reported.
+//
+// Build: make -C host test
+// Use:   host/testSerialTx
+//        make -C host FIRMWARE_FLAGS=-DUART_TX_DMA test
+//
+// *******************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "inc/hw_memmap.h"
+#include "driverlib/sysctl.h"
+#include "driverlib/uart.h"
+#include "serialCom.h"
+#include "motorControl.h"
+#include "timingConfig.h"
+#include "hostSim.h"
+#include "hostTest.h"
+
+#define TEST_ROUNDS 20000
+#define MAX_SEND 300                //Longest single send, more than a quarter of the queue
+#define RELEASE_ONE_IN 4            //Chance of releasing the transmitter after each send
+#define LINE_MAX (1 << 22)          //Bytes captured from the line
+#define TX_FIFO 16                  //Tx FIFO depth of the part
+#define DRAIN_CYCLES CPU_CLOCK_HZ   //Virtual time for the paced line to send a report, one second
+
+//The firmware's text report, or binary frame with TELEMETRY_BINARY
+void updateSerial(uint16_t PWMMain, uint16_t PWMTail);
+
+static uint8_t      line[LINE_MAX];
+static uint32_t     lineLength;
+static uint8_t      expected[LINE_MAX];
+static uint32_t     expectedLength;
+
+//The report captured by testReport, and the virtual time each way of sending it held up the caller
+static uint8_t      report[UART_TX_BUF_SIZE];
+static uint32_t     reportLength;
+static uint64_t     queuedCycles;
+static uint64_t     blockingCycles;
+
+static void
+capture(uint8_t byte)
+/* Record a byte sent on the line
+ */
+{
+    if (lineLength < LINE_MAX) {
+        line[lineLength] = byte;
+    }
+    lineLength++;
+}
+
+static void
+testStall(void)
+/* A send while stalled queues the bytes and returns without sending any; they go once the stall is released
+ */
+{
+    static const char text[] = "Current Height = 50%\n";
+    uint16_t dropped;
+
+    hostStallUARTTx(true);
+    dropped = UARTSend((char *)text);
+    CHECK(dropped == 0, "%u bytes dropped from an empty queue", dropped);
+    CHECK(lineLength == 0, "%u bytes sent while stalled", lineLength);
+    hostStallUARTTx(false);
+    CHECK(lineLength == strlen(text) && memcmp(line, text, strlen(text)) == 0, "sent %u bytes, not \"%s\"",
+          lineLength, text);
+    lineLength = 0;
+}
+
+static void
+testOverflow(void)
+/* Bytes beyond a full queue are dropped and counted, and those before them still go
+ */
+{
+    static uint8_t data[UART_TX_BUF_SIZE + 10];
+    uint32_t i;
+    uint16_t dropped;
+
+    for (i = 0; i < sizeof(data); i++) {
+        data[i] = (uint8_t)(i * 7);
+    }
+    hostStallUARTTx(true);
+    dropped = UARTSendBytes(data, sizeof(data));
+    CHECK(dropped == 10, "%u bytes dropped, not 10", dropped);
+    CHECK(getUARTDropCount() == 10, "drop count %u, not 10", getUARTDropCount());
+    hostStallUARTTx(false);
+    CHECK(lineLength == UART_TX_BUF_SIZE && memcmp(line, data, UART_TX_BUF_SIZE) == 0,
+          "sent %u bytes, not the first %u queued", lineLength, UART_TX_BUF_SIZE);
+    lineLength = 0;
+}
+
+static void
+testRandomSends(void)
+/* Random sends and releases. A model of the queue gives the bytes it accepts, which must be the bytes on the line
+ */
+{
+    static uint8_t data[MAX_SEND];
+    uint32_t seed = 1;
+    uint32_t round;
+    uint32_t queued = 0;
+    uint32_t dropCount = getUARTDropCount();
+    uint16_t length;
+    uint16_t accepted;
+    uint16_t dropped;
+    uint16_t i;
+
+    hostStallUARTTx(true);
+    for (round = 0; round < TEST_ROUNDS; round++) {
+        length = testRandom(&seed) % (MAX_SEND + 1);
+        for (i = 0; i < length; i++) {
+            data[i] = (uint8_t)testRandom(&seed);
+        }
+        accepted = length < UART_TX_BUF_SIZE - queued ? length : UART_TX_BUF_SIZE - queued;
+        if (expectedLength + accepted > LINE_MAX) {
+            break;
+        }
+        memcpy(&expected[expectedLength], data, accepted);
+        expectedLength += accepted;
+        queued += accepted;
+        dropCount += length - accepted;
+
+        dropped = UARTSendBytes(data, length);
+        if (!CHECK(dropped == length - accepted, "round %u: %u of %u bytes dropped, not %u", round, dropped,
+                   length, length - accepted)
+            || !CHECK(lineLength + queued == expectedLength, "round %u: %u bytes sent while stalled", round,
+                      lineLength + queued - expectedLength)) {
+            break;
+        }
+        if (testRandom(&seed) % RELEASE_ONE_IN == 0) {
+            hostStallUARTTx(false);
+            hostStallUARTTx(true);
+            queued = 0;
+        }
+    }
+    hostStallUARTTx(false);
+    CHECK(getUARTDropCount() == dropCount, "drop count %u, not %u", getUARTDropCount(), dropCount);
+    CHECK(lineLength == expectedLength && memcmp(line, expected, lineLength) == 0,
+          "sent %u bytes differing from the %u queued", lineLength, expectedLength);
+    printf("testSerialTx: %u bytes sent, %u dropped, through a %u byte queue\n", lineLength, dropCount,
+           UART_TX_BUF_SIZE);
+    lineLength = 0;
+}
+
+static void
+testReport(void)
+/* A whole report is queued at once while the line is busy, without a drop
+ */
+{
+    uint32_t dropCount = getUARTDropCount();
+
+    hostStallUARTTx(true);
+    updateSerial(PWM_DUTY_SCALE, PWM_DUTY_SCALE);
+    CHECK(getUARTDropCount() == dropCount, "%u bytes of a report dropped", getUARTDropCount() - dropCount);
+    hostStallUARTTx(false);
+    CHECK(lineLength > 0, "no report sent");
+    printf("testSerialTx: report of %u bytes\n", lineLength);
+    reportLength = lineLength < sizeof(report) ? lineLength : sizeof(report);
+    memcpy(report, line, reportLength);
+    lineLength = 0;
+}
+
+static void
+blockingSend(const uint8_t *pucBuffer, uint32_t length)
+/* UARTSend() as it was before the transmit queue, waiting for space in the Tx FIFO for each byte
+ */
+{
+    while (length--) {
+        UARTCharPut(UART_USB_BASE, *pucBuffer);
+        pucBuffer++;
+    }
+}
+
+static int
+sendReports(void)
+/* Run by hostRun: time sending the report through the queue, then by blockingSend(), letting the line empty after each
+ */
+{
+    uint64_t start;
+
+    start = hostTime();
+    UARTSendBytes(report, reportLength);
+    queuedCycles = hostTime() - start;
+    SysCtlDelay(DRAIN_CYCLES / 3);
+    start = hostTime();
+    blockingSend(report, reportLength);
+    blockingCycles = hostTime() - start;
+    SysCtlDelay(DRAIN_CYCLES / 3);
+    return 0;
+}
+
+static void
+testBlocking(void)
+/* On a paced line, queuing the report holds up the caller for no time, and the old blocking send for as long as the
+ * line takes to send all but a FIFO of it
+ */
+{
+    uint32_t length = reportLength;
+    uint64_t byteCycles = (uint64_t)CPU_CLOCK_HZ * UART_BITS_PER_BYTE / BAUD_RATE;
+
+    hostPaceUARTTx(true);
+    hostRun(sendReports, 3 * DRAIN_CYCLES);
+    hostPaceUARTTx(false);
+    CHECK(lineLength == 2 * length && memcmp(line, report, length) == 0 && memcmp(&line[length], report, length) == 0,
+          "sent %u bytes, not the report twice", lineLength);
+    CHECK(queuedCycles == 0, "queued report held up the caller for %u cycles", (uint32_t)queuedCycles);
+    CHECK(blockingCycles >= (length - TX_FIFO - 1) * byteCycles,
+          "blocking report held up the caller for %u cycles, less than the line takes", (uint32_t)blockingCycles);
+    printf("testSerialTx: a %u byte report at %u baud holds up the caller %.1f ms queued, %.1f ms blocking\n",
+           length, BAUD_RATE, queuedCycles * 1000.0 / CPU_CLOCK_HZ, blockingCycles * 1000.0 / CPU_CLOCK_HZ);
+    lineLength = 0;
+}
+
+int
+main(void)
+{
+    hostSetUARTOutput(capture);
+    initialiseUSB_UART();
+    testStall();
+    testOverflow();
+    testRandomSends();
+    testReport();
+    testBlocking();
+    return testSummary("testSerialTx");
+}
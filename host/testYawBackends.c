@@ -0,0 +1,98 @@
+// *******************************************************
+//
+// testYawBackends.c
+//
+// Test that the two heliYaw backends, GPIO edge interrupts and the
+// QEI, give the same yaw. heliYaw.c is built twice into this test,
+// once with YAW_USE_QEI, with each build's functions renamed with a
+// gpio_ or qei_ prefix (see the Makefile). A pseudo-random walk of
+// encoder edges, with reversals and passes through the reference,
+// drives the simulated encoder pins and the simulated QEI together,
+// as heliPlant does, and after every edge the two must agree on the
+// yaw count and on whether the rig is homed. Every edge is a legal
+// transition; a missed edge is counted differently by the two.
+//
+// Build: make -C host test
+// Use:   host/testYawBackends
+//
+// *******************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "inc/hw_memmap.h"
+#include "driverlib/gpio.h"
+#include "heliYaw.h"
+#include "hostSim.h"
+#include "heliPlant.h"
+#include "hostTest.h"
+
+#define TEST_EDGES 200000
+#define START_COUNT 100             //Encoder count at the start, away from the reference. A multiple of 4, state 0
+#define REVERSE_ONE_IN 8            //Chance of reversing at each edge
+
+//The two builds of heliYaw.c
+void gpio_initYaw(void);
+int16_t gpio_getCurrentYaw(void);
+int8_t gpio_isHomed(void);
+void qei_initYaw(void);
+int16_t qei_getCurrentYaw(void);
+int8_t qei_isHomed(void);
+
+//Encoder state, (B << 1) | A, in order of increasing yaw; B leads A
+static const uint8_t encoderStates[4] = { 0, 2, 3, 1 };
+
+static void
+stepEncoder(int32_t *count, int8_t direction)
+/* Move the encoder one edge in direction on both the GPIO pins and the QEI, pulsing the reference signal low as
+ * the count passes a multiple of ENCODER_COUNTS
+ */
+{
+    int32_t last = *count;
+    uint8_t changed;
+
+    *count += direction;
+    changed = encoderStates[last & 3] ^ encoderStates[*count & 3];
+    if (changed & 1) {
+        hostSetPin(GPIO_PORTB_BASE, ENCODER_A_PIN, encoderStates[*count & 3] & 1);
+    } else {
+        hostSetPin(GPIO_PORTB_BASE, ENCODER_B_PIN, encoderStates[*count & 3] & 2);
+    }
+    hostQEIMove(direction);
+    if (*count % ENCODER_COUNTS == 0) {
+        hostSetPin(GPIO_PORTC_BASE, REF_PIN, false);
+        hostSetPin(GPIO_PORTC_BASE, REF_PIN, true);
+        hostQEIIndex();
+    }
+}
+
+int
+main(void)
+{
+    uint32_t seed = 1;
+    uint32_t edge;
+    int32_t count = START_COUNT;
+    int8_t direction = -1;
+    bool homedBefore = false;
+
+    hostSetPin(GPIO_PORTB_BASE, ENCODER_A_PIN | ENCODER_B_PIN, false);
+    hostSetPin(GPIO_PORTC_BASE, REF_PIN, true);
+    gpio_initYaw();
+    qei_initYaw();
+    for (edge = 0; edge < TEST_EDGES; edge++) {
+        if (testRandom(&seed) % REVERSE_ONE_IN == 0) {
+            direction = -direction;
+        }
+        stepEncoder(&count, direction);
+        if (!CHECK(gpio_getCurrentYaw() == qei_getCurrentYaw(), "edge %u at count %d: GPIO yaw %d, QEI yaw %d",
+                   edge, count, gpio_getCurrentYaw(), qei_getCurrentYaw())
+            || !CHECK(gpio_isHomed() == qei_isHomed(), "edge %u at count %d: GPIO homed %d, QEI homed %d", edge,
+                      count, gpio_isHomed(), qei_isHomed())) {
+            break;
+        }
+        homedBefore = homedBefore || gpio_isHomed();
+    }
+    CHECK(homedBefore, "the walk never passed the reference");
+    return testSummary("testYawBackends");
+}
@@ -0,0 +1,248 @@
+// *******************************************************
+//
+// testYawDecode.c
+//
+// Missed edge replay and microbenchmark of the quadrature decoder in
+// yawIntHandler. A pseudo-random walk of encoder edges is recorded
+// as the state each interrupt would read, with MISSED_ONE_IN edges
+// missed: the next edge comes before the interrupt, so it reads a
+// state with both A and B changed, an illegal transition. The trace
+// is replayed through:
+//
+//  - the nested switch decoder yawIntHandler had before, copied here
+//  - the transition table decoder it has now, copied here
+//  - yawIntHandler itself, with the trace driven onto the simulated
+//    encoder pins, the missed edges with interrupts masked
+//
+// All three must give the walk's count less the missed edges, and
+// the table decoder and yawIntHandler must count each illegal
+// transition as an error. The walk reverses at random, so every legal
+// transition is in the trace too. The two copies are then timed over
+// the trace, in host nanoseconds per transition; this is host time,
+// for comparing the two on one machine, and not a measure of the ISR
+// on the target.
+//
+// Build: make -C host test
+// Use:   host/testYawDecode
+//
+// *******************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "inc/hw_memmap.h"
+#include "driverlib/gpio.h"
+#include "driverlib/interrupt.h"
+#include "heliYaw.h"
+#include "hostSim.h"
+#include "hostClock.h"
+#include "hostTest.h"
+
+#define TEST_TRANSITIONS 1000000
+#define MISSED_ONE_IN 50            //Chance of an edge being missed
+#define REVERSE_ONE_IN 8            //Chance of the walk reversing at each edge
+#define TIMING_PASSES 20
+
+//The GPIO build of heliYaw.c, whatever the firmware build options (see the Makefile)
+void gpio_initYaw(void);
+int16_t gpio_getCurrentYaw(void);
+uint32_t gpio_getYawErrorCount(void);
+
+//Encoder state, (B << 1) | A, in order of increasing yaw; B leads A
+static const uint8_t encoderStates[4] = { 0, 2, 3, 1 };
+
+//The table in heliYaw.c
+static const int8_t yawTransition[16] = {
+     0, -1,  1,  0,     //from 0
+     1,  0,  0, -1,     //from 1
+    -1,  0,  0,  1,     //from 2
+     0,  1, -1,  0      //from 3
+};
+
+//State read by each interrupt, and whether the edge before it was missed
+static uint8_t      trace[TEST_TRANSITIONS];
+static bool         missed[TEST_TRANSITIONS];
+static int32_t      expectedCount;
+static uint32_t     expectedErrors;
+
+static void
+makeTrace(void)
+/* Walk the encoder, recording the state at each interrupt and the count the decoders should reach. A missed edge
+ * moves the encoder two edges between interrupts, which no decoder can count
+ */
+{
+    uint32_t seed = 1;
+    uint32_t i;
+    int32_t position = 0;
+    int8_t direction = 1;
+
+    for (i = 0; i < TEST_TRANSITIONS; i++) {
+        if (testRandom(&seed) % REVERSE_ONE_IN == 0) {
+            direction = -direction;
+        }
+        position += direction;
+        missed[i] = testRandom(&seed) % MISSED_ONE_IN == 0;
+        if (missed[i]) {
+            position += direction;
+            expectedErrors++;
+        } else {
+            expectedCount += direction;
+        }
+        trace[i] = encoderStates[position & 3];
+    }
+}
+
+static int16_t
+switchDecode(const uint8_t *states, uint32_t count)
+/* The decoder yawIntHandler had before the transition table, over a trace of states from state 0
+ */
+{
+    int16_t currentYawCount = 0;
+    uint32_t lastYawState = 0;
+    uint32_t currentYawState;
+    uint32_t i;
+
+    for (i = 0; i < count; i++) {
+        currentYawState = states[i];
+        switch(currentYawState)
+        {
+        case 0:
+            switch(lastYawState)
+            {
+            case 1:
+                currentYawCount++;
+                break;
+            case 2:
+                currentYawCount--;
+                break;
+            }
+            break;
+        case 1:
+            switch(lastYawState)
+            {
+            case 3:
+                currentYawCount++;
+                break;
+            case 0:
+                currentYawCount--;
+                break;
+            }
+            break;
+        case 2:
+            switch(lastYawState)
+            {
+            case 0:
+                currentYawCount++;
+                break;
+            case 3:
+                currentYawCount--;
+                break;
+            }
+            break;
+        case 3:
+            switch(lastYawState)
+            {
+            case 2:
+                currentYawCount++;
+                break;
+            case 1:
+                currentYawCount--;
+                break;
+            }
+            break;
+        }
+        lastYawState = currentYawState;
+    }
+    return currentYawCount;
+}
+
+static int16_t
+tableDecode(const uint8_t *states, uint32_t count, uint32_t *errors)
+/* The transition table decoder of yawIntHandler, over a trace of states from state 0
+ */
+{
+    int16_t currentYawCount = 0;
+    uint32_t lastYawState = 0;
+    uint32_t currentYawState;
+    uint32_t i;
+
+    *errors = 0;
+    for (i = 0; i < count; i++) {
+        currentYawState = states[i];
+        currentYawCount += yawTransition[(lastYawState << 2) | currentYawState];
+        *errors += ((lastYawState ^ currentYawState) == 3);
+        lastYawState = currentYawState;
+    }
+    return currentYawCount;
+}
+
+static void
+replayFirmware(void)
+/* Drive the trace onto the simulated encoder pins for yawIntHandler, one pin per edge. Both edges of a missed pair
+ * are driven with interrupts masked, so the handler runs once and reads the state after both
+ */
+{
+    uint8_t last = 0;
+    uint32_t i;
+
+    hostSetPin(GPIO_PORTB_BASE, ENCODER_A_PIN | ENCODER_B_PIN, false);
+    hostSetPin(GPIO_PORTC_BASE, REF_PIN, true);
+    gpio_initYaw();
+    for (i = 0; i < TEST_TRANSITIONS; i++) {
+        if (missed[i]) {
+            IntMasterDisable();
+        }
+        if ((last ^ trace[i]) & 1) {
+            hostSetPin(GPIO_PORTB_BASE, ENCODER_A_PIN, trace[i] & 1);
+        }
+        if ((last ^ trace[i]) & 2) {
+            hostSetPin(GPIO_PORTB_BASE, ENCODER_B_PIN, trace[i] & 2);
+        }
+        if (missed[i]) {
+            IntMasterEnable();
+        }
+        last = trace[i];
+    }
+    CHECK(gpio_getCurrentYaw() == (int16_t)expectedCount, "yawIntHandler: count %d, expected %d", gpio_getCurrentYaw(),
+          (int16_t)expectedCount);
+    CHECK(gpio_getYawErrorCount() == expectedErrors, "yawIntHandler: %u errors, expected %u", gpio_getYawErrorCount(),
+          expectedErrors);
+}
+
+static double
+timeDecoder(bool table)
+/* Return the mean host nanoseconds per transition of a decoder over the trace
+ */
+{
+    uint32_t pass;
+    uint32_t errors;
+    uint64_t start = hostNanoseconds();
+    volatile int16_t sink;
+
+    for (pass = 0; pass < TIMING_PASSES; pass++) {
+        sink = table ? tableDecode(trace, TEST_TRANSITIONS, &errors) : switchDecode(trace, TEST_TRANSITIONS);
+    }
+    (void)sink;
+    return (double)(hostNanoseconds() - start) / ((uint64_t)TEST_TRANSITIONS * TIMING_PASSES);
+}
+
+int
+main(void)
+{
+    int16_t count;
+    uint32_t errors;
+
+    makeTrace();
+
+    count = switchDecode(trace, TEST_TRANSITIONS);
+    CHECK(count == (int16_t)expectedCount, "switch decoder: count %d, expected %d", count, (int16_t)expectedCount);
+    count = tableDecode(trace, TEST_TRANSITIONS, &errors);
+    CHECK(count == (int16_t)expectedCount, "table decoder: count %d, expected %d", count, (int16_t)expectedCount);
+    CHECK(errors == expectedErrors, "table decoder: %u errors, expected %u", errors, expectedErrors);
+    replayFirmware();
+
+    printf("testYawDecode: %u transitions, %u missed edges, switch %.3f ns, table %.3f ns per transition on the "
+           "host\n", TEST_TRANSITIONS, expectedErrors, timeDecoder(false), timeDecoder(true));
+    return testSummary("testYawDecode");
+}
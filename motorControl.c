@@ -36,6 +36,23 @@ void initMainPWM (void);
 void initTailPWM (void);
 void setPWMMain (uint32_t u32Duty);
 void setPWMTail (uint32_t u32Duty);
+
+//Main rotor duty last set, parts per PWM_DUTY_SCALE
+static uint32_t mainDuty;
+
+/********************************************************
+ * Compare value for a duty in parts per PWM_DUTY_SCALE.
+ * Full duty is held one count short of the period, as a
+ * compare equal to the load value never switches the output
+ ********************************************************/
+static uint32_t
+dutyWidth (uint32_t u32Duty)
+{
+    if (u32Duty >= PWM_DUTY_SCALE) {
+        return PWM_PERIOD - 1;
+    }
+    return u32Duty * PWM_PERIOD / PWM_DUTY_SCALE;
+}
 /************************************************************/
 /* InitialiseMainPWM
  * M0PWM7 (J4-05, PC5) is used for the main rotor motor
@@ -50,10 +67,13 @@ initMainPWM (void)
     GPIOPinTypePWM(PWM_MAIN_GPIO_BASE, PWM_MAIN_GPIO_PIN);
 
 
+    // With PWM_GEN_MODE_NO_SYNC, load and compare updates latch locally when the
+    // counter next reaches zero, so a period never mixes an old and a new duty
     PWMGenConfigure(PWM_MAIN_BASE, PWM_MAIN_GEN,
                     PWM_GEN_MODE_UP_DOWN | PWM_GEN_MODE_NO_SYNC);
 
-    // Set the initial PWM parameters
+    // The period is set once; duty updates only write the compare register
+    PWMGenPeriodSet(PWM_MAIN_BASE, PWM_MAIN_GEN, PWM_PERIOD);
     setPWMMain(PWM_DUTY_START);
 
     PWMGenEnable(PWM_MAIN_BASE, PWM_MAIN_GEN);
@@ -77,7 +97,8 @@ initTailPWM (void)
 
     PWMGenConfigure(PWM_TAIL_BASE, PWM_TAIL_GEN,
                     PWM_GEN_MODE_UP_DOWN | PWM_GEN_MODE_NO_SYNC);
-    // Set the initial PWM parameters
+
+    PWMGenPeriodSet(PWM_TAIL_BASE, PWM_TAIL_GEN, PWM_PERIOD);
     setPWMTail(PWM_DUTY_START);
 
     PWMGenEnable(PWM_TAIL_BASE, PWM_TAIL_GEN);
@@ -87,29 +108,33 @@ initTailPWM (void)
 }
 
 /********************************************************
- * Function to set the freq, duty cycle of M0PWM7
+ * Function to set the duty cycle of M0PWM7, in parts per
+ * PWM_DUTY_SCALE. Takes effect at the next zero count
  ********************************************************/
 void
 setPWMMain (uint32_t u32Duty)
 {
-    // Calculate the PWM period corresponding to the freq.
-    uint32_t u32Period = SysCtlClockGet() / PWM_DIVIDER / PWM_RATE_HZ;
+    PWMPulseWidthSet(PWM_MAIN_BASE, PWM_MAIN_OUTNUM, dutyWidth(u32Duty));
+    mainDuty = u32Duty;
+}
 
-    PWMGenPeriodSet(PWM_MAIN_BASE, PWM_MAIN_GEN, u32Period);
-    PWMPulseWidthSet(PWM_MAIN_BASE, PWM_MAIN_OUTNUM, u32Period * u32Duty / 100);
+/********************************************************
+ * Function to get the duty cycle last set on M0PWM7
+ ********************************************************/
+uint32_t
+getPWMMain (void)
+{
+    return mainDuty;
 }
 
 /********************************************************
- * Function to set the freq, duty cycle of M1PWM5
+ * Function to set the duty cycle of M1PWM5, in parts per
+ * PWM_DUTY_SCALE. Takes effect at the next zero count
  ********************************************************/
 void
 setPWMTail (uint32_t u32Duty)
 {
-    // Calculate the PWM period corresponding to the freq.
-    uint32_t u32Period = SysCtlClockGet() / PWM_DIVIDER / PWM_RATE_HZ;
-
-    PWMGenPeriodSet(PWM_TAIL_BASE, PWM_TAIL_GEN, u32Period);
-    PWMPulseWidthSet(PWM_TAIL_BASE, PWM_TAIL_OUTNUM, u32Period * u32Duty / 100);
+    PWMPulseWidthSet(PWM_TAIL_BASE, PWM_TAIL_OUTNUM, dutyWidth(u32Duty));
 }
 
 void
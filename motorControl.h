@@ -17,15 +17,26 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "timingConfig.h"
 
-
-#define SYSTICK_RATE_HZ    100
 // PWM configuration
 #define PWM_RATE_HZ         200
 #define PWM_DIVIDER_CODE    SYSCTL_PWMDIV_4
 #define PWM_DIVIDER         4
 #define PWM_DUTY_START      0
 
+// Generator load value, fixed at compile time from the system clock. Up-down
+// counting makes the output PWM_RATE_HZ with this period
+#define PWM_PERIOD          (CPU_CLOCK_HZ / PWM_DIVIDER / PWM_RATE_HZ)
+
+// Duty cycles are given in parts per PWM_DUTY_SCALE (per ten thousand) throughout
+#define PWM_DUTY_SCALE      10000
+#define PWM_PERCENT(p)      ((p) * (PWM_DUTY_SCALE / 100))
+
+TIMING_ASSERT(CPU_CLOCK_HZ % (PWM_DIVIDER * PWM_RATE_HZ) == 0, pwmPeriodWhole);
+TIMING_ASSERT(PWM_PERIOD <= 0xFFFF, pwmPeriodFitsGenerator);
+TIMING_ASSERT(PWM_PERIOD >= PWM_DUTY_SCALE, pwmPeriodResolvesDuty);
+
 //  PWM Hardware Details M0PWM7 (gen 3)
 //  ---Main Rotor PWM: PC5, J4-05
 #define PWM_MAIN_BASE        PWM0_BASE
@@ -62,6 +73,9 @@ setPWMMain (uint32_t u32Duty);
 void
 setPWMTail (uint32_t u32Duty);
 
+uint32_t
+getPWMMain (void);
+
 void
 enablePWMOutput(void);
 
@@ -0,0 +1,121 @@
+// *******************************************************
+//
+// profile.c
+//
+// Cycle-count profiling of interrupt handlers and tasks. Only built
+// with PROFILE_ENABLE defined in profile.h.
+//
+// *******************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "profile.h"
+
+#ifdef PROFILE_ENABLE
+
+#include "driverlib/interrupt.h"
+#include "utils/ustdlib.h"
+#include "serialCom.h"
+
+typedef struct {
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t sum;
+    uint32_t hist[PROFILE_HIST_BINS];
+} profileStats_t;
+
+uint32_t                profileStart[PROFILE_REGIONS];
+static profileStats_t   profileStats[PROFILE_REGIONS];
+
+static const char * const profileNames[PROFILE_REGIONS] = {
+    "SysTick ISR",
+    "ADC ISR",
+    "Yaw ISR",
+    "Scheduler ISR",
+    "UART ISR",
+    "calcHeightADC",
+    "PIDMainControl",
+    "PIDTailControl",
+    "updateSerial"
+};
+
+void
+profileRecord(profileRegion_t region, uint32_t cycles)
+/* Add one run of a region to its statistics. Called from PROFILE_END, in interrupt or task context
+ */
+{
+    profileStats_t *stats = &profileStats[region];
+    uint8_t bin = 0;
+
+    //Bin is the number of significant bits in the cycle count
+    while (cycles >> bin && bin < PROFILE_HIST_BINS - 1) {
+        bin++;
+    }
+    if (stats->count == 0 || cycles < stats->min) {
+        stats->min = cycles;
+    }
+    if (cycles > stats->max) {
+        stats->max = cycles;
+    }
+    stats->sum += cycles;
+    stats->count++;
+    stats->hist[bin]++;
+}
+
+void
+profileReset(void)
+/* Clear the statistics of every region
+ */
+{
+    uint8_t region;
+    uint8_t bin;
+
+    IntMasterDisable();
+    for (region = 0; region < PROFILE_REGIONS; region++) {
+        profileStats[region].count = 0;
+        profileStats[region].min = 0;
+        profileStats[region].max = 0;
+        profileStats[region].sum = 0;
+        for (bin = 0; bin < PROFILE_HIST_BINS; bin++) {
+            profileStats[region].hist[bin] = 0;
+        }
+    }
+    IntMasterEnable();
+}
+
+bool
+profileDump(void)
+/* Send the statistics of the next region over serial, one region per call so the transmit queue is not overrun.
+ * Returns true once the last region has been sent. Each region is copied with interrupts masked so its figures agree
+ */
+{
+    static uint8_t region = 0;
+    profileStats_t stats;
+    char string[MAX_STR_LEN];
+    uint8_t bin;
+
+    IntMasterDisable();
+    stats = profileStats[region];
+    IntMasterEnable();
+
+    usnprintf (string, sizeof(string), "%s: n=%u min=%u mean=%u max=%u\n", profileNames[region], stats.count,
+               stats.min, stats.count ? (uint32_t)(stats.sum / stats.count) : 0, stats.max);
+    UARTSend (string);
+    //Histogram, non-empty bins only, labelled with the upper bound of the bin in bits
+    for (bin = 0; bin < PROFILE_HIST_BINS; bin++) {
+        if (stats.hist[bin]) {
+            usnprintf (string, sizeof(string), " <2^%u:%u", bin, stats.hist[bin]);
+            UARTSend (string);
+        }
+    }
+    UARTSend ("\n");
+
+    if (++region >= PROFILE_REGIONS) {
+        region = 0;
+        return true;
+    }
+    return false;
+}
+
+#endif /*PROFILE_ENABLE*/
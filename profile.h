@@ -0,0 +1,66 @@
+// *******************************************************
+//
+// profile.h
+//
+// Cycle-count profiling of interrupt handlers and tasks, timed with
+// the DWT cycle counter (cpuCycles). Each region keeps a run count,
+// minimum, maximum and mean, and a log2 histogram. Bin b of the
+// histogram counts runs of 2^(b-1) to 2^b - 1 cycles, and the
+// last bin also counts everything longer.
+//
+// Wrap a region in PROFILE_START(region) and PROFILE_END(region).
+// Regions must not nest with themselves. Without PROFILE_ENABLE
+// the macros are empty and no profiling code or data is built.
+//
+// *******************************************************
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//Build option: define to profile the regions below and dump them over serial
+//#define PROFILE_ENABLE
+
+#define PROFILE_HIST_BINS 20    //Up to 2^19 cycles (26 ms at 20 MHz) in the last bin
+#define PROFILE_DUMP_CHAR 'p'   //Character received over serial that requests a dump
+#define PROFILE_RESET_CHAR 'r'  //Character received over serial that clears the statistics
+
+//Profiled regions
+typedef enum {
+    PROFILE_SYSTICK_ISR = 0,
+    PROFILE_ADC_ISR,
+    PROFILE_YAW_ISR,
+    PROFILE_SCHED_ISR,
+    PROFILE_UART_ISR,
+    PROFILE_CALC_HEIGHT,
+    PROFILE_PID_MAIN,
+    PROFILE_PID_TAIL,
+    PROFILE_SERIAL,
+    PROFILE_REGIONS
+} profileRegion_t;
+
+#ifdef PROFILE_ENABLE
+
+#include "cpuCycles.h"
+
+extern uint32_t profileStart[PROFILE_REGIONS];
+
+#define PROFILE_START(region)   (profileStart[region] = getCPUCycles())
+#define PROFILE_END(region)     profileRecord(region, getCPUCycles() - profileStart[region])
+
+void profileRecord(profileRegion_t region, uint32_t cycles);
+
+void profileReset(void);
+
+bool profileDump(void);
+
+#else
+
+#define PROFILE_START(region)
+#define PROFILE_END(region)
+
+#endif /*PROFILE_ENABLE*/
+
+#endif /*PROFILE_H*/
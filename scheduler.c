@@ -0,0 +1,153 @@
+// *******************************************************
+//
+// scheduler.c
+//
+// Cooperative periodic task scheduler with overrun detection and
+// CPU load measurement.
+//
+// *******************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "inc/hw_types.h"
+#include "driverlib/sysctl.h"
+#include "driverlib/interrupt.h"
+#include "cpuCycles.h"
+#include "scheduler.h"
+
+static task_t       *tasks;
+static uint8_t      taskCount;
+
+//CPU load measurement
+static uint32_t     idleCycles;             //Total cycles spent asleep
+static uint8_t      loadPercent;
+static uint16_t     loadTicks;              //Ticks into the current load window
+static uint32_t     windowStart;            //getCPUCycles() at the start of the window
+static uint32_t     windowIdle;             //idleCycles at the start of the window
+
+void
+initScheduler(task_t *taskTable, uint8_t numTasks)
+/* Take the task table and set each task to be released first on its phase tick
+ */
+{
+    uint8_t i;
+
+    tasks = taskTable;
+    taskCount = numTasks;
+    for (i = 0; i < taskCount; i++) {
+        tasks[i].released = false;
+        tasks[i].countdown = tasks[i].phase;
+    }
+}
+
+void
+schedulerTick(void)
+/* Called from the periodic timer interrupt. Release each task whose period has elapsed; a task that is released again
+ * before it has run has missed its deadline. Every SCHED_LOAD_TICKS work out the CPU load from the time spent asleep
+ */
+{
+    uint32_t now;
+    uint32_t total;
+    uint8_t i;
+
+    for (i = 0; i < taskCount; i++) {
+        if (tasks[i].countdown == 0) {
+            if (tasks[i].released) {
+                tasks[i].misses++;
+            }
+            tasks[i].released = true;
+            tasks[i].countdown = tasks[i].period - 1;
+        } else {
+            tasks[i].countdown--;
+        }
+    }
+
+    if (++loadTicks >= SCHED_LOAD_TICKS) {
+        now = getCPUCycles();
+        total = now - windowStart;
+        loadPercent = 100 - (uint8_t)((uint64_t)(idleCycles - windowIdle) * 100 / total);
+        windowStart = now;
+        windowIdle = idleCycles;
+        loadTicks = 0;
+    }
+}
+
+static task_t *
+nextTask(void)
+/* Return the most urgent released task, or NULL if none are due
+ */
+{
+    task_t *next = 0;
+    uint8_t i;
+
+    for (i = 0; i < taskCount; i++) {
+        if (tasks[i].released && (next == 0 || tasks[i].priority < next->priority)) {
+            next = &tasks[i];
+        }
+    }
+    return next;
+}
+
+void
+schedulerRun(void)
+/* Run released tasks for ever. When none are due, sleep until the next interrupt. Interrupts are masked while checking
+ * for work so a release cannot slip in between the check and WFI; WFI still wakes on the pending interrupt.
+ * The first load window starts here, so start up and initialisation are not counted as load
+ */
+{
+    task_t *task;
+    uint32_t start;
+    uint32_t cycles;
+
+    IntMasterDisable();
+    loadTicks = 0;
+    windowStart = getCPUCycles();
+    windowIdle = idleCycles;
+    IntMasterEnable();
+
+    while (1) {
+        task = nextTask();
+        if (task) {
+            task->released = false;
+            start = getCPUCycles();
+            task->run();
+            cycles = getCPUCycles() - start;
+            if (cycles > task->maxCycles) {
+                task->maxCycles = cycles;
+            }
+            if (cycles > task->budget) {
+                task->overruns++;
+            }
+        } else {
+            IntMasterDisable();
+            if (nextTask() == 0) {
+                start = getCPUCycles();
+                SysCtlSleep();
+                idleCycles += getCPUCycles() - start;
+            }
+            IntMasterEnable();
+        }
+    }
+}
+
+uint8_t
+getSchedulerLoad(void)
+/* Return the percentage of time the CPU was busy over the last SCHED_LOAD_TICKS
+ */
+{
+    return loadPercent;
+}
+
+uint32_t
+getSchedulerOverruns(void)
+/* Return the total number of budget overruns and missed releases over all tasks
+ */
+{
+    uint32_t total = 0;
+    uint8_t i;
+
+    for (i = 0; i < taskCount; i++) {
+        total += tasks[i].overruns + tasks[i].misses;
+    }
+    return total;
+}
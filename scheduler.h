@@ -0,0 +1,46 @@
+// *******************************************************
+//
+// scheduler.h
+//
+// Cooperative periodic task scheduler. Tasks are listed in a static
+// table and released by schedulerTick(), called from a periodic
+// timer interrupt. schedulerRun() runs released tasks to completion,
+// most urgent first, and sleeps the core with WFI when nothing is
+// due. Each run is timed in CPU cycles against the task's budget, and
+// idle time is measured to give the CPU load.
+//
+// *******************************************************
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SCHED_LOAD_TICKS 100    //Ticks per CPU load measurement
+
+typedef struct {
+    void (*run)(void);          // Task function, runs to completion
+    uint16_t period;            // Release period in scheduler ticks
+    uint16_t phase;             // Tick of the first release, to spread tasks out
+    uint8_t priority;           // 0 is most urgent
+    uint32_t budget;            // Worst-case run time in CPU cycles
+    // Kept by the scheduler
+    volatile bool released;     // Due to run
+    uint16_t countdown;         // Ticks to the next release
+    uint32_t maxCycles;         // Longest run seen
+    uint32_t overruns;          // Runs longer than budget
+    volatile uint32_t misses;   // Releases while the previous one had not run
+} task_t;
+
+void initScheduler(task_t *taskTable, uint8_t numTasks);
+
+void schedulerTick(void);
+
+void schedulerRun(void);
+
+uint8_t getSchedulerLoad(void);
+
+uint32_t getSchedulerOverruns(void);
+
+#endif /*SCHEDULER_H*/
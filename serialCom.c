@@ -10,18 +10,24 @@
 #include "inc/hw_memmap.h"
 #include "inc/hw_types.h"
 #include "inc/hw_ints.h"
+#include "inc/hw_uart.h"
 #include "driverlib/gpio.h"
 #include "driverlib/uart.h"
 #include "driverlib/sysctl.h"
 #include "driverlib/systick.h"
 #include "driverlib/debug.h"
 #include "driverlib/pin_map.h"
+#include "driverlib/interrupt.h"
+#include "driverlib/udma.h"
 #include "utils/ustdlib.h"
 #include "stdio.h"
+#include "string.h"
 #include "stdlib.h"
 #include "OrbitOLED/OrbitOLEDInterface.h"
 #include "buttons4.h"
 #include "serialCom.h"
+#include "dmaControl.h"
+#include "profile.h"
 
 //********************************************************
 // Constants
@@ -31,6 +37,48 @@
 //********************************************************
 // Global variables
 //********************************************************
+// Transmit queue. txHead is advanced by UARTSend, txTail by the
+// UART interrupt; both run freely and are masked on access.
+static volatile char txBuf[UART_TX_BUF_SIZE];
+static volatile uint32_t txHead;
+static volatile uint32_t txTail;
+static volatile uint32_t txDropCount;   // Bytes lost to a full queue
+#ifdef UART_TX_DMA
+static volatile uint32_t txDMALength;   // Bytes in the transfer in progress
+#endif
+
+//********************************************************
+// Move queued bytes towards the UART. Called with the UART
+// interrupt masked, or from the UART interrupt itself.
+//********************************************************
+static void
+UARTPrimeTransmit (void)
+{
+#ifdef UART_TX_DMA
+    uint32_t start;
+    uint32_t length;
+
+    if (txDMALength != 0 || txHead == txTail)
+        return;
+    // Send as far as the queued data or the end of the buffer,
+    // whichever comes first
+    start = txTail & (UART_TX_BUF_SIZE - 1);
+    length = txHead - txTail;
+    if (length > UART_TX_BUF_SIZE - start)
+        length = UART_TX_BUF_SIZE - start;
+    txDMALength = length;
+    uDMAChannelTransferSet(UDMA_CHANNEL_UART0TX | UDMA_PRI_SELECT, UDMA_MODE_BASIC,
+                           (void *)&txBuf[start], (void *)(UART_USB_BASE + UART_O_DR), length);
+    uDMAChannelEnable(UDMA_CHANNEL_UART0TX);
+#else
+    // Fill the Tx FIFO; the Tx interrupt asks for more as it empties
+    while (txHead != txTail && UARTSpaceAvail(UART_USB_BASE))
+    {
+        UARTCharPutNonBlocking(UART_USB_BASE, txBuf[txTail & (UART_TX_BUF_SIZE - 1)]);
+        txTail++;
+    }
+#endif
+}
 
 //*******************************************************************
 // initialiseUSB_UART - 8 bits, 1 stop bit, no parity
@@ -55,20 +103,104 @@ initialiseUSB_UART (void)
 			UART_CONFIG_PAR_NONE);
     UARTFIFOEnable(UART_USB_BASE);
     UARTEnable(UART_USB_BASE);
-}
 
+    UARTIntRegister(UART_USB_BASE, UARTIntHandler);
+#ifdef UART_TX_DMA
+    // The uDMA completion interrupt arrives on the UART vector
+    initDMA();
+    uDMAChannelAssign(UDMA_CH9_UART0TX);
+    uDMAChannelAttributeDisable(UDMA_CHANNEL_UART0TX, UDMA_ATTR_ALL);
+    uDMAChannelControlSet(UDMA_CHANNEL_UART0TX | UDMA_PRI_SELECT,
+                          UDMA_SIZE_8 | UDMA_SRC_INC_8 | UDMA_DST_INC_NONE | UDMA_ARB_4);
+    UARTFIFOLevelSet(UART_USB_BASE, UART_FIFO_TX4_8, UART_FIFO_RX4_8);
+    UARTDMAEnable(UART_USB_BASE, UART_DMA_TX);
+#else
+    // Interrupt as the Tx FIFO drains below 1/8 full
+    UARTTxIntModeSet(UART_USB_BASE, UART_TXINT_MODE_FIFO);
+    UARTFIFOLevelSet(UART_USB_BASE, UART_FIFO_TX1_8, UART_FIFO_RX4_8);
+    UARTIntEnable(UART_USB_BASE, UART_INT_TX);
+#endif
+}
 
 //**********************************************************************
-// Transmit a string via UART0
+// UART0 interrupt: refill the Tx FIFO from the queue, or start the
+// next uDMA transfer once the last one has finished.
 //**********************************************************************
 void
-UARTSend (char *pucBuffer)
+UARTIntHandler (void)
 {
-    // Loop while there are more characters to send.
-    while(*pucBuffer)
+    PROFILE_START(PROFILE_UART_ISR);
+    UARTIntClear(UART_USB_BASE, UARTIntStatus(UART_USB_BASE, true));
+#ifdef UART_TX_DMA
+    if (txDMALength != 0 && !uDMAChannelIsEnabled(UDMA_CHANNEL_UART0TX))
     {
-        // Write the next character to the UART Tx FIFO.
-        UARTCharPut(UART_USB_BASE, *pucBuffer);
+        txTail += txDMALength;
+        txDMALength = 0;
+    }
+#endif
+    UARTPrimeTransmit();
+    PROFILE_END(PROFILE_UART_ISR);
+}
+
+
+//**********************************************************************
+// Queue bytes for transmission via UART0 without waiting. Returns
+// the number of bytes dropped because the queue was full.
+//**********************************************************************
+uint16_t
+UARTSendBytes (const uint8_t *pucBuffer, uint16_t length)
+{
+    uint16_t dropped = 0;
+    uint32_t head = txHead;
+
+    // Loop while there are more bytes to send.
+    while(length--)
+    {
+        // Queue the next byte if there is room for it.
+        if (head - txTail < UART_TX_BUF_SIZE)
+        {
+            txBuf[head & (UART_TX_BUF_SIZE - 1)] = *pucBuffer;
+            head++;
+        }
+        else
+            dropped++;
         pucBuffer++;
     }
+    txHead = head;
+    txDropCount += dropped;
+
+    // Start sending with the UART interrupt masked, so it cannot
+    // prime the transmitter at the same time.
+    IntDisable(INT_UART0);
+    UARTPrimeTransmit();
+    IntEnable(INT_UART0);
+    return dropped;
+}
+
+//**********************************************************************
+// Queue a string for transmission via UART0 without waiting. Returns
+// the number of characters dropped because the queue was full.
+//**********************************************************************
+uint16_t
+UARTSend (char *pucBuffer)
+{
+    return UARTSendBytes ((const uint8_t *)pucBuffer, strlen (pucBuffer));
+}
+
+//**********************************************************************
+// Return the total number of characters dropped by UARTSend
+//**********************************************************************
+uint32_t
+getUARTDropCount (void)
+{
+    return txDropCount;
+}
+
+//**********************************************************************
+// Return the next character received via UART0, or -1 if there is none
+//**********************************************************************
+int32_t
+UARTReceive (void)
+{
+    return UARTCharGetNonBlocking (UART_USB_BASE);
 }
@@ -4,11 +4,14 @@
 #include <stdint.h>
 #include <stdbool.h>
 
-#define SLOWTICK_RATE_HZ 4
 #define MAX_STR_LEN 100
 
 //---USB Serial comms: UART0, Rx:PA0 , Tx:PA1
+//Build option: override at build time for a faster line, e.g. -DBAUD_RATE=115200, which TELEMETRY_BINARY needs
+#ifndef BAUD_RATE
 #define BAUD_RATE 9600
+#endif
+#define UART_BITS_PER_BYTE 10   //Start bit, eight data bits and a stop bit
 #define UART_USB_BASE           UART0_BASE
 #define UART_USB_PERIPH_UART    SYSCTL_PERIPH_UART0
 #define UART_USB_PERIPH_GPIO    SYSCTL_PERIPH_GPIOA
@@ -17,11 +20,25 @@
 #define UART_USB_GPIO_PIN_TX    GPIO_PIN_1
 #define UART_USB_GPIO_PINS      UART_USB_GPIO_PIN_RX | UART_USB_GPIO_PIN_TX
 
+//Transmit queue drained by the UART interrupt, must be a power of two. Sized to hold a whole text report from
+//updateSerial(), which HeliProject.c checks at compile time
+#define UART_TX_BUF_SIZE 1024
+//Build option: define to drain the transmit queue by uDMA instead of from the UART interrupt
+//#define UART_TX_DMA
+
 //********************************************************
 // Prototypes
 //********************************************************
 void initialiseUSB_UART (void);
 
-void UARTSend (char *pucBuffer);
+uint16_t UARTSendBytes (const uint8_t *pucBuffer, uint16_t length);
+
+uint16_t UARTSend (char *pucBuffer);
+
+uint32_t getUARTDropCount (void);
+
+int32_t UARTReceive (void);
+
+void UARTIntHandler (void);
 
 #endif /*SERIALCOM_H*/
@@ -0,0 +1,127 @@
+// *******************************************************
+//
+// telemetry.c
+//
+// Compact binary telemetry frames for the serial link: packing,
+// CRC-16 and COBS framing.
+//
+// *******************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "telemetry.h"
+
+static uint8_t *
+put16(uint8_t *p, uint16_t value)
+{
+    *p++ = value & 0xFF;
+    *p++ = value >> 8;
+    return p;
+}
+
+static uint16_t
+get16(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+uint16_t
+telemetryCRC16(const uint8_t *data, uint16_t length)
+/* Bitwise CRC-16/CCITT-FALSE. Frames are short, so a table is not worth the flash
+ */
+{
+    uint16_t crc = 0xFFFF;
+    uint8_t bit;
+
+    while (length--) {
+        crc ^= (uint16_t)(*data++) << 8;
+        for (bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+uint16_t
+telemetryEncode(const telemetry_t *sample, uint8_t *frame)
+/* Pack the sample and its CRC, then COBS encode it into frame. Each run of non-zero bytes is preceded by a code byte
+ * giving the distance to the next zero, so the only zero in the output is the delimiter
+ */
+{
+    uint8_t raw[TELEMETRY_PAYLOAD_LEN + TELEMETRY_CRC_LEN];
+    uint8_t *p = raw;
+    uint8_t *code;
+    uint8_t *out;
+    uint16_t i;
+
+    p = put16(p, sample->timeMs & 0xFFFF);
+    p = put16(p, sample->timeMs >> 16);
+    p = put16(p, sample->height);
+    p = put16(p, sample->targetHeight);
+    p = put16(p, (uint16_t)sample->yaw);
+    p = put16(p, (uint16_t)sample->targetYaw);
+    p = put16(p, sample->dutyMain);
+    p = put16(p, sample->dutyTail);
+    *p++ = sample->flightMode;
+    put16(p, telemetryCRC16(raw, TELEMETRY_PAYLOAD_LEN));
+
+    code = frame;
+    out = frame + 1;
+    *code = 1;
+    for (i = 0; i < sizeof(raw); i++) {
+        if (raw[i] == 0) {
+            code = out++;
+            *code = 1;
+        } else {
+            *out++ = raw[i];
+            (*code)++;
+        }
+    }
+    *out++ = 0;
+    return out - frame;
+}
+
+bool
+telemetryDecode(const uint8_t *frame, uint16_t length, telemetry_t *sample)
+/* COBS decode frame, check the length and CRC and unpack the sample
+ */
+{
+    uint8_t raw[TELEMETRY_PAYLOAD_LEN + TELEMETRY_CRC_LEN];
+    uint16_t rawLength = 0;
+    uint16_t i = 0;
+    uint8_t code;
+    uint8_t j;
+
+    while (i < length) {
+        code = frame[i++];
+        if (code == 0) {
+            return false;
+        }
+        for (j = 1; j < code; j++) {
+            if (i >= length || rawLength >= sizeof(raw) || frame[i] == 0) {
+                return false;
+            }
+            raw[rawLength++] = frame[i++];
+        }
+        if (code < 0xFF && i < length) {
+            if (rawLength >= sizeof(raw)) {
+                return false;
+            }
+            raw[rawLength++] = 0;
+        }
+    }
+    if (rawLength != sizeof(raw)
+            || telemetryCRC16(raw, TELEMETRY_PAYLOAD_LEN) != get16(&raw[TELEMETRY_PAYLOAD_LEN])) {
+        return false;
+    }
+
+    sample->timeMs = get16(&raw[0]) | ((uint32_t)get16(&raw[2]) << 16);
+    sample->height = get16(&raw[4]);
+    sample->targetHeight = get16(&raw[6]);
+    sample->yaw = (int16_t)get16(&raw[8]);
+    sample->targetYaw = (int16_t)get16(&raw[10]);
+    sample->dutyMain = get16(&raw[12]);
+    sample->dutyTail = get16(&raw[14]);
+    sample->flightMode = raw[16];
+    return true;
+}
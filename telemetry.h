@@ -0,0 +1,51 @@
+// *******************************************************
+//
+// telemetry.h
+//
+// Compact binary telemetry frames for the serial link, as an
+// alternative to the text report. Each frame carries one sample of
+// the heli state in a little-endian payload, followed by a CRC-16,
+// and is COBS encoded so that a zero byte only ever marks the end of
+// a frame. Has no hardware dependencies, so the host decoder builds
+// it as well.
+//
+// *******************************************************
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//Build option: define to send binary telemetry frames at the control rate instead of the text report. The frames
+//need a faster line than the default BAUD_RATE, e.g. -DBAUD_RATE=115200
+//#define TELEMETRY_BINARY
+
+#define TELEMETRY_PAYLOAD_LEN 17
+#define TELEMETRY_CRC_LEN 2
+//Payload and CRC, plus one byte of COBS overhead and the zero delimiter
+#define TELEMETRY_FRAME_MAX (TELEMETRY_PAYLOAD_LEN + TELEMETRY_CRC_LEN + 2)
+
+typedef struct {
+    uint32_t timeMs;        // Time since start up
+    uint16_t height;        // Current height in %
+    uint16_t targetHeight;  // Target height in %
+    int16_t yaw;            // Current yaw in degrees
+    int16_t targetYaw;      // Target yaw in degrees
+    uint16_t dutyMain;      // Main rotor duty, per ten thousand
+    uint16_t dutyTail;      // Tail rotor duty, per ten thousand
+    uint8_t flightMode;
+} telemetry_t;
+
+// CRC-16/CCITT-FALSE (polynomial 0x1021, initial value 0xFFFF)
+uint16_t telemetryCRC16(const uint8_t *data, uint16_t length);
+
+// Encode a sample into frame, which must hold TELEMETRY_FRAME_MAX bytes.
+// Returns the frame length including the zero delimiter.
+uint16_t telemetryEncode(const telemetry_t *sample, uint8_t *frame);
+
+// Decode a frame received without its zero delimiter. Returns false if
+// the frame is malformed or fails its CRC.
+bool telemetryDecode(const uint8_t *frame, uint16_t length, telemetry_t *sample);
+
+#endif /*TELEMETRY_H*/
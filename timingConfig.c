@@ -0,0 +1,113 @@
+// *******************************************************
+//
+// timingConfig.c
+//
+// Free-running timestamp timer, and self-measurement of the sample,
+// control and slow tick rates against it.
+//
+// *******************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "inc/hw_memmap.h"
+#include "inc/hw_types.h"
+#include "driverlib/sysctl.h"
+#include "driverlib/timer.h"
+#include "timingConfig.h"
+
+static const uint32_t configuredRates[TIMING_SOURCES] = { SAMPLE_RATE_HZ, CONTROL_RATE_HZ, SLOWTICK_RATE_HZ };
+
+static volatile uint32_t tickCount[TIMING_SOURCES];    //Ticks since start up
+static uint32_t     windowCount[TIMING_SOURCES];        //tickCount at the start of the window
+static uint32_t     windowStart;                        //getTimingClock() at the start of the window
+static uint32_t     measuredRates[TIMING_SOURCES];      //Over the last full window, tenths of a hertz
+static volatile uint32_t uptimeTicks;                   //SysTick interrupts since start up
+
+void
+initTiming(void)
+/* Start the timestamp timer free-running over its full 32 bits, and the first measurement window
+ */
+{
+    uint8_t i;
+
+    SysCtlPeripheralEnable(TIMING_TIMER_PERIPH);
+    TimerConfigure(TIMING_TIMER_BASE, TIMER_CFG_PERIODIC);
+    TimerLoadSet(TIMING_TIMER_BASE, TIMER_A, 0xFFFFFFFF);
+    TimerEnable(TIMING_TIMER_BASE, TIMER_A);
+
+    windowStart = getTimingClock();
+    for (i = 0; i < TIMING_SOURCES; i++) {
+        windowCount[i] = tickCount[i];
+    }
+}
+
+uint32_t
+getTimingClock(void)
+/* Return the timestamp timer as a count up at CPU_CLOCK_HZ, wrapping every 2^32 cycles (215 s at 20 MHz)
+ */
+{
+    return ~TimerValueGet(TIMING_TIMER_BASE, TIMER_A);
+}
+
+void
+countTiming(timingSource_t source, uint32_t ticks)
+/* Count ticks of a source. Call from the one place that source runs, interrupt or task
+ */
+{
+    tickCount[source] += ticks;
+}
+
+void
+updateTiming(void)
+/* Close the measurement window once TIMING_WINDOW_S has passed, and work out each rate over it.
+ * Call regularly, at least every few seconds
+ */
+{
+    uint32_t now = getTimingClock();
+    uint32_t elapsed = now - windowStart;
+    uint32_t count;
+    uint8_t i;
+
+    if (elapsed < (uint32_t)CPU_CLOCK_HZ * TIMING_WINDOW_S) {
+        return;
+    }
+    for (i = 0; i < TIMING_SOURCES; i++) {
+        count = tickCount[i];
+        measuredRates[i] = (uint32_t)(((uint64_t)(count - windowCount[i]) * CPU_CLOCK_HZ * 10 + elapsed / 2)
+                                      / elapsed);
+        windowCount[i] = count;
+    }
+    windowStart = now;
+}
+
+uint32_t
+getMeasuredRate(timingSource_t source)
+/* Return the rate a source achieved over the last full window, in tenths of a hertz. 0 until the first window closes
+ */
+{
+    return measuredRates[source];
+}
+
+uint32_t
+getConfiguredRate(timingSource_t source)
+/* Return the rate a source is configured for, in tenths of a hertz
+ */
+{
+    return configuredRates[source] * 10;
+}
+
+void
+tickUptime(void)
+/* Advance the uptime clock. Call from SysTickIntHandler only
+ */
+{
+    uptimeTicks++;
+}
+
+uint32_t
+getUptimeMs(void)
+/* Return the time since SysTick was started, in milliseconds, wrapping after 49 days
+ */
+{
+    return (uint32_t)((uint64_t)uptimeTicks * 1000 / SYSTICK_RATE_HZ);
+}
@@ -0,0 +1,87 @@
+// *******************************************************
+//
+// timingConfig.h
+//
+// The firmware's timing, in one place. The altitude sample rate,
+// controller rate and slow tick rate are set here, and the timer
+// periods, slow task divider, controller time step and height window
+// are derived from them at compile time. TIMING_ASSERT checks that
+// each derived value comes out whole and in range, so a change that
+// would make two modules disagree fails to build.
+//
+// timingConfig.c also keeps a free-running timer for timestamps, and
+// counts sample, control and slow ticks against it to report the
+// rates actually achieved next to the configured ones. SysTick keeps
+// the uptime clock, and is not used to time anything else.
+//
+// *******************************************************
+
+#ifndef TIMINGCONFIG_H
+#define TIMINGCONFIG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//Configured rates
+#define CPU_CLOCK_HZ 20000000       //System clock set by initClock
+#define SAMPLE_RATE_HZ 200          //Altitude sensor samples
+#define CONTROL_RATE_HZ 200         //Scheduler tick and controllers, 100 to 500 Hz
+#define SLOWTICK_RATE_HZ 4          //Display and text serial reports
+#define SYSTICK_RATE_HZ 1000        //Uptime clock
+#define HEIGHT_WINDOW_MS 250        //Span of the mean height buffer
+
+//Derived values
+#define SAMPLE_PERIOD_CYCLES (CPU_CLOCK_HZ / SAMPLE_RATE_HZ)
+#define CONTROL_PERIOD_CYCLES (CPU_CLOCK_HZ / CONTROL_RATE_HZ)
+#define SYSTICK_PERIOD_CYCLES (CPU_CLOCK_HZ / SYSTICK_RATE_HZ)
+#define SYSTICKS_PER_SAMPLE (SYSTICK_RATE_HZ / SAMPLE_RATE_HZ)  //For processor triggered sampling only
+#define SAMPLES_PER_CONTROL (SAMPLE_RATE_HZ / CONTROL_RATE_HZ)
+#define SLOW_TASK_PERIOD (CONTROL_RATE_HZ / SLOWTICK_RATE_HZ)  //Scheduler ticks per slow tick
+#define DELTA_T (1.0 / CONTROL_RATE_HZ)                         //Controller integration step, seconds
+#define BUF_SIZE (SAMPLE_RATE_HZ * HEIGHT_WINDOW_MS / 1000)    //Samples in the mean height buffer
+
+//Compile time check, for compilers without _Static_assert: an array of negative size if cond is false
+#define TIMING_ASSERT(cond, name) typedef char timingAssert_##name[(cond) ? 1 : -1]
+
+TIMING_ASSERT(CPU_CLOCK_HZ % SAMPLE_RATE_HZ == 0, samplePeriodWhole);
+TIMING_ASSERT(CPU_CLOCK_HZ % CONTROL_RATE_HZ == 0, controlPeriodWhole);
+TIMING_ASSERT(CPU_CLOCK_HZ % SYSTICK_RATE_HZ == 0, sysTickPeriodWhole);
+TIMING_ASSERT(SYSTICK_PERIOD_CYCLES <= 0x1000000, sysTickPeriodFits);
+TIMING_ASSERT(SYSTICK_RATE_HZ % 1000 == 0 || 1000 % SYSTICK_RATE_HZ == 0, sysTickMillisecondsWhole);
+TIMING_ASSERT(SAMPLE_RATE_HZ % CONTROL_RATE_HZ == 0, samplesPerControlWhole);
+TIMING_ASSERT(CONTROL_RATE_HZ % SLOWTICK_RATE_HZ == 0, slowTaskPeriodWhole);
+TIMING_ASSERT(CONTROL_RATE_HZ >= 100 && CONTROL_RATE_HZ <= 500, controlRateInRange);
+TIMING_ASSERT(SAMPLE_RATE_HZ * HEIGHT_WINDOW_MS % 1000 == 0, heightWindowWhole);
+TIMING_ASSERT(BUF_SIZE >= 1, heightWindowNotEmpty);
+
+//Free-running timestamp timer, counting down from 2^32 - 1 at the system clock
+#define TIMING_TIMER_PERIPH SYSCTL_PERIPH_TIMER2
+#define TIMING_TIMER_BASE TIMER2_BASE
+
+//Rate self-measurement
+#define TIMING_WINDOW_S 2           //Ticks are counted over windows of this length
+
+typedef enum {
+    TIMING_SAMPLE = 0,
+    TIMING_CONTROL,
+    TIMING_SLOW,
+    TIMING_SOURCES
+} timingSource_t;
+
+void initTiming(void);
+
+uint32_t getTimingClock(void);
+
+void countTiming(timingSource_t source, uint32_t ticks);
+
+void updateTiming(void);
+
+uint32_t getMeasuredRate(timingSource_t source);
+
+uint32_t getConfiguredRate(timingSource_t source);
+
+void tickUptime(void);
+
+uint32_t getUptimeMs(void);
+
+#endif /*TIMINGCONFIG_H*/